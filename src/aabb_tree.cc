@@ -0,0 +1,309 @@
+#include "aabb_tree.h"
+
+#include <algorithm>
+#include <utility>
+
+bool Aabb::contains(Aabb const& a_other) const
+{
+  return min.x <= a_other.min.x && min.y <= a_other.min.y && min.z <= a_other.min.z &&
+    a_other.max.x <= max.x && a_other.max.y <= max.y && a_other.max.z <= max.z;
+}
+
+bool Aabb::overlaps(Aabb const& a_other) const
+{
+  return min.x <= a_other.max.x && a_other.min.x <= max.x &&
+    min.y <= a_other.max.y && a_other.min.y <= max.y &&
+    min.z <= a_other.max.z && a_other.min.z <= max.z;
+}
+
+float Aabb::getSurfaceArea() const
+{
+  float const x = max.x - min.x;
+  float const y = max.y - min.y;
+  float const z = max.z - min.z;
+  return 2.0f * (x * y + y * z + z * x);
+}
+
+Aabb Aabb::combine(Aabb const& a_lhs, Aabb const& a_rhs)
+{
+  Aabb result{};
+  result.min = glm::vec3{ std::min(a_lhs.min.x, a_rhs.min.x), std::min(a_lhs.min.y, a_rhs.min.y),
+    std::min(a_lhs.min.z, a_rhs.min.z) };
+  result.max = glm::vec3{ std::max(a_lhs.max.x, a_rhs.max.x), std::max(a_lhs.max.y, a_rhs.max.y),
+    std::max(a_lhs.max.z, a_rhs.max.z) };
+  return result;
+}
+
+AabbTree::AabbTree(float a_margin)
+  : m_margin{ a_margin }
+{
+}
+
+int32_t AabbTree::createProxy(Aabb const& a_aabb, uint32_t a_userData)
+{
+  int32_t const proxy = allocateNode();
+
+  Node& node = m_nodes[proxy];
+  node.aabb.min = a_aabb.min - glm::vec3{ m_margin, m_margin, m_margin };
+  node.aabb.max = a_aabb.max + glm::vec3{ m_margin, m_margin, m_margin };
+  node.userData = a_userData;
+  node.height = 0;
+
+  insertLeaf(proxy);
+  ++m_proxyCount;
+
+  return proxy;
+}
+
+void AabbTree::destroyProxy(int32_t a_proxy)
+{
+  removeLeaf(a_proxy);
+  freeNode(a_proxy);
+  --m_proxyCount;
+}
+
+bool AabbTree::moveProxy(int32_t a_proxy, Aabb const& a_aabb)
+{
+  Node& node = m_nodes[a_proxy];
+  if (node.aabb.contains(a_aabb))
+    return false;
+
+  removeLeaf(a_proxy);
+
+  node.aabb.min = a_aabb.min - glm::vec3{ m_margin, m_margin, m_margin };
+  node.aabb.max = a_aabb.max + glm::vec3{ m_margin, m_margin, m_margin };
+
+  insertLeaf(a_proxy);
+  return true;
+}
+
+void AabbTree::clear()
+{
+  m_nodes.clear();
+  m_root = NULL_NODE;
+  m_freeList = NULL_NODE;
+  m_proxyCount = 0;
+}
+
+int32_t AabbTree::allocateNode()
+{
+  if (m_freeList == NULL_NODE) {
+    m_nodes.emplace_back();
+    return static_cast<int32_t>(m_nodes.size() - 1);
+  }
+
+  int32_t const node = m_freeList;
+  m_freeList = m_nodes[node].parent;
+  m_nodes[node] = Node{};
+  return node;
+}
+
+void AabbTree::freeNode(int32_t a_node)
+{
+  m_nodes[a_node] = Node{};
+  m_nodes[a_node].parent = m_freeList;
+  m_freeList = a_node;
+}
+
+// Walks down to the sibling that grows the total surface area the least, the cost
+// heuristic of Box2D's dynamic tree, then rebalances on the way back up.
+void AabbTree::insertLeaf(int32_t a_leaf)
+{
+  if (m_root == NULL_NODE) {
+    m_root = a_leaf;
+    m_nodes[a_leaf].parent = NULL_NODE;
+    return;
+  }
+
+  Aabb const leafAabb{ m_nodes[a_leaf].aabb };
+  int32_t index{ m_root };
+
+  while (!m_nodes[index].isLeaf()) {
+    Node const& node = m_nodes[index];
+
+    float const area = node.aabb.getSurfaceArea();
+    float const combinedArea = Aabb::combine(node.aabb, leafAabb).getSurfaceArea();
+
+    // creating a new parent here, and what every level below inherits
+    float const cost = 2.0f * combinedArea;
+    float const inheritanceCost = 2.0f * (combinedArea - area);
+
+    auto const descendCost = [&](int32_t a_child) {
+      Node const& child = m_nodes[a_child];
+      float const grown = Aabb::combine(child.aabb, leafAabb).getSurfaceArea();
+      return child.isLeaf() ? grown + inheritanceCost : grown - child.aabb.getSurfaceArea() + inheritanceCost;
+    };
+
+    float const cost1 = descendCost(node.child1);
+    float const cost2 = descendCost(node.child2);
+
+    if (cost < cost1 && cost < cost2)
+      break;
+
+    index = cost1 < cost2 ? node.child1 : node.child2;
+  }
+
+  int32_t const sibling{ index };
+  int32_t const oldParent{ m_nodes[sibling].parent };
+  int32_t const newParent{ allocateNode() };
+
+  Node& parent = m_nodes[newParent];
+  parent.parent = oldParent;
+  parent.aabb = Aabb::combine(leafAabb, m_nodes[sibling].aabb);
+  parent.height = m_nodes[sibling].height + 1;
+  parent.child1 = sibling;
+  parent.child2 = a_leaf;
+
+  if (oldParent != NULL_NODE) {
+    if (m_nodes[oldParent].child1 == sibling)
+      m_nodes[oldParent].child1 = newParent;
+    else
+      m_nodes[oldParent].child2 = newParent;
+  } else {
+    m_root = newParent;
+  }
+
+  m_nodes[sibling].parent = newParent;
+  m_nodes[a_leaf].parent = newParent;
+
+  refit(newParent);
+}
+
+void AabbTree::removeLeaf(int32_t a_leaf)
+{
+  if (a_leaf == m_root) {
+    m_root = NULL_NODE;
+    return;
+  }
+
+  int32_t const parent{ m_nodes[a_leaf].parent };
+  int32_t const grandParent{ m_nodes[parent].parent };
+  int32_t const sibling{ m_nodes[parent].child1 == a_leaf ? m_nodes[parent].child2 : m_nodes[parent].child1 };
+
+  if (grandParent != NULL_NODE) {
+    if (m_nodes[grandParent].child1 == parent)
+      m_nodes[grandParent].child1 = sibling;
+    else
+      m_nodes[grandParent].child2 = sibling;
+
+    m_nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    refit(grandParent);
+  } else {
+    m_root = sibling;
+    m_nodes[sibling].parent = NULL_NODE;
+    freeNode(parent);
+  }
+}
+
+void AabbTree::refit(int32_t a_node)
+{
+  for (int32_t index = a_node; index != NULL_NODE; index = m_nodes[index].parent) {
+    index = balance(index);
+
+    Node& node = m_nodes[index];
+    Node const& child1 = m_nodes[node.child1];
+    Node const& child2 = m_nodes[node.child2];
+
+    node.height = 1 + std::max(child1.height, child2.height);
+    node.aabb = Aabb::combine(child1.aabb, child2.aabb);
+  }
+}
+
+// Rotates the taller grandchild up when the children of a_node differ in height by more
+// than one. Returns the node now at the position of a_node.
+int32_t AabbTree::balance(int32_t a_node)
+{
+  Node& a = m_nodes[a_node];
+  if (a.isLeaf() || a.height < 2)
+    return a_node;
+
+  int32_t const indexB{ a.child1 };
+  int32_t const indexC{ a.child2 };
+  int32_t const difference{ m_nodes[indexC].height - m_nodes[indexB].height };
+
+  if (difference >= -1 && difference <= 1)
+    return a_node;
+
+  // the taller child moves up, a_node becomes its child
+  int32_t const indexUp{ difference > 1 ? indexC : indexB };
+  int32_t const indexStay{ difference > 1 ? indexB : indexC };
+
+  Node& up = m_nodes[indexUp];
+  int32_t const indexF{ up.child1 };
+  int32_t const indexG{ up.child2 };
+
+  up.child1 = a_node;
+  up.parent = a.parent;
+  a.parent = indexUp;
+
+  if (up.parent != NULL_NODE) {
+    if (m_nodes[up.parent].child1 == a_node)
+      m_nodes[up.parent].child1 = indexUp;
+    else
+      m_nodes[up.parent].child2 = indexUp;
+  } else {
+    m_root = indexUp;
+  }
+
+  // the taller grandchild stays with the node moving up, the other one replaces it
+  bool const fTaller = m_nodes[indexF].height > m_nodes[indexG].height;
+  int32_t const indexKeep{ fTaller ? indexF : indexG };
+  int32_t const indexGive{ fTaller ? indexG : indexF };
+
+  up.child2 = indexKeep;
+
+  if (difference > 1)
+    a.child2 = indexGive;
+  else
+    a.child1 = indexGive;
+
+  m_nodes[indexGive].parent = a_node;
+
+  Node const& stay = m_nodes[indexStay];
+  Node const& give = m_nodes[indexGive];
+  a.aabb = Aabb::combine(stay.aabb, give.aabb);
+  a.height = 1 + std::max(stay.height, give.height);
+
+  Node const& keep = m_nodes[indexKeep];
+  up.aabb = Aabb::combine(a.aabb, keep.aabb);
+  up.height = 1 + std::max(a.height, keep.height);
+
+  return indexUp;
+}
+
+// slab test of the segment a_from + t * a_delta, t in [0, a_maxFraction]
+bool AabbTree::intersectSegment(Aabb const& a_aabb, glm::vec3 const& a_from, glm::vec3 const& a_delta,
+  float a_maxFraction)
+{
+  float tMin{ 0.0f };
+  float tMax{ a_maxFraction };
+
+  for (int axis = 0; axis < 3; ++axis) {
+    float const from = a_from[axis];
+    float const delta = a_delta[axis];
+    float const min = a_aabb.min[axis];
+    float const max = a_aabb.max[axis];
+
+    if (std::abs(delta) < 1e-8f) {
+      if (from < min || from > max)
+        return false;
+      continue;
+    }
+
+    float const inverse = 1.0f / delta;
+    float t1 = (min - from) * inverse;
+    float t2 = (max - from) * inverse;
+    if (t1 > t2)
+      std::swap(t1, t2);
+
+    tMin = std::max(tMin, t1);
+    tMax = std::min(tMax, t2);
+
+    if (tMin > tMax)
+      return false;
+  }
+
+  return true;
+}
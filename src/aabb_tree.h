@@ -0,0 +1,147 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+struct Aabb {
+  glm::vec3 min{};
+  glm::vec3 max{};
+
+  bool contains(Aabb const& a_other) const;
+  bool overlaps(Aabb const& a_other) const;
+  float getSurfaceArea() const;
+
+  static Aabb combine(Aabb const& a_lhs, Aabb const& a_rhs);
+};
+
+// Dynamic bounding volume hierarchy over boxes with a user value each, kept balanced with
+// tree rotations. Leaves store a box enlarged by a margin, so a body that moves a little
+// only costs a containment test; it is reinserted once it leaves its enlarged box.
+class AabbTree {
+public:
+  static constexpr int32_t NULL_NODE = -1;
+
+  explicit AabbTree(float a_margin = 0.5f);
+
+  int32_t createProxy(Aabb const& a_aabb, uint32_t a_userData);
+  void destroyProxy(int32_t a_proxy);
+  // true when the proxy was reinserted
+  bool moveProxy(int32_t a_proxy, Aabb const& a_aabb);
+  void clear();
+
+  uint32_t getUserData(int32_t a_proxy) const { return m_nodes[a_proxy].userData; }
+  void setUserData(int32_t a_proxy, uint32_t a_userData) { m_nodes[a_proxy].userData = a_userData; }
+  Aabb const& getFatAabb(int32_t a_proxy) const { return m_nodes[a_proxy].aabb; }
+
+  size_t getProxyCount() const { return m_proxyCount; }
+  int32_t getHeight() const { return m_root == NULL_NODE ? 0 : m_nodes[m_root].height; }
+
+  // a_function(proxy) for every proxy whose box overlaps a_aabb, returns false to stop
+  template<class Function>
+  void query(Aabb const& a_aabb, Function&& a_function) const;
+
+  // Sweeps a sphere of a_radius (0 for a ray) from a_from to a_to. a_function(proxy,
+  // maxFraction) is called for every proxy the swept sphere may touch and returns the
+  // fraction of the segment to clip the search to: 0 stops, maxFraction continues.
+  template<class Function>
+  void rayCast(glm::vec3 const& a_from, glm::vec3 const& a_to, float a_radius, Function&& a_function) const;
+
+private:
+  // deep enough for any tree the rotations keep balanced
+  static constexpr size_t MAX_STACK = 256;
+
+  struct Node {
+    Aabb aabb{};
+    uint32_t userData{};
+    // the parent, or the next free node while on the free list
+    int32_t parent{ NULL_NODE };
+    int32_t child1{ NULL_NODE };
+    int32_t child2{ NULL_NODE };
+    // leaves are 0, free nodes -1
+    int32_t height{ -1 };
+
+    bool isLeaf() const { return child1 == NULL_NODE; }
+  };
+
+  int32_t allocateNode();
+  void freeNode(int32_t a_node);
+  void insertLeaf(int32_t a_leaf);
+  void removeLeaf(int32_t a_leaf);
+  int32_t balance(int32_t a_node);
+  void refit(int32_t a_node);
+
+  static bool intersectSegment(Aabb const& a_aabb, glm::vec3 const& a_from, glm::vec3 const& a_delta,
+    float a_maxFraction);
+
+  std::vector<Node> m_nodes{};
+  int32_t m_root{ NULL_NODE };
+  int32_t m_freeList{ NULL_NODE };
+  size_t m_proxyCount{};
+  float m_margin{};
+};
+
+template<class Function>
+void AabbTree::query(Aabb const& a_aabb, Function&& a_function) const
+{
+  int32_t stack[MAX_STACK];
+  size_t count{};
+
+  if (m_root != NULL_NODE)
+    stack[count++] = m_root;
+
+  while (count > 0) {
+    Node const& node = m_nodes[stack[--count]];
+    if (!node.aabb.overlaps(a_aabb))
+      continue;
+
+    if (node.isLeaf()) {
+      if (!a_function(static_cast<int32_t>(&node - m_nodes.data())))
+        return;
+    } else if (count + 2 <= MAX_STACK) {
+      stack[count++] = node.child1;
+      stack[count++] = node.child2;
+    }
+  }
+}
+
+template<class Function>
+void AabbTree::rayCast(glm::vec3 const& a_from, glm::vec3 const& a_to, float a_radius, Function&& a_function) const
+{
+  glm::vec3 const delta{ a_to.x - a_from.x, a_to.y - a_from.y, a_to.z - a_from.z };
+  float maxFraction{ 1.0f };
+
+  int32_t stack[MAX_STACK];
+  size_t count{};
+
+  if (m_root != NULL_NODE)
+    stack[count++] = m_root;
+
+  while (count > 0) {
+    Node const& node = m_nodes[stack[--count]];
+
+    Aabb bounds{ node.aabb };
+    bounds.min -= glm::vec3{ a_radius, a_radius, a_radius };
+    bounds.max += glm::vec3{ a_radius, a_radius, a_radius };
+
+    if (!intersectSegment(bounds, a_from, delta, maxFraction))
+      continue;
+
+    if (node.isLeaf()) {
+      float const fraction = a_function(static_cast<int32_t>(&node - m_nodes.data()), maxFraction);
+      if (fraction <= 0.0f)
+        return;
+
+      maxFraction = std::fmin(maxFraction, fraction);
+    } else if (count + 2 <= MAX_STACK) {
+      stack[count++] = node.child1;
+      stack[count++] = node.child2;
+    }
+  }
+}
+
+#endif //AABB_TREE_H
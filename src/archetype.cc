@@ -0,0 +1,48 @@
+#include "archetype.h"
+
+namespace {
+
+template<EntityType Type>
+void assign_type_tag(entt::registry& a_registry, entt::entity a_entity)
+{
+  a_registry.assign_or_replace<TypeTag<Type>>(a_entity);
+}
+
+} // namespace
+
+std::optional<EntityType> Archetypes::find_by_model(std::string_view a_path)
+{
+  for (size_t i = 0; i < ARCHETYPE_TRAITS.size(); ++i) {
+    if (!ARCHETYPE_TRAITS[i].modelPath.empty() && ARCHETYPE_TRAITS[i].modelPath == a_path)
+      return static_cast<EntityType>(i);
+  }
+
+  return {};
+}
+
+void Archetypes::assign_tag(entt::registry& a_registry, entt::entity a_entity, EntityType a_type)
+{
+  switch (a_type) {
+    case EntityType::AsteroidFragment:
+      assign_type_tag<EntityType::AsteroidFragment>(a_registry, a_entity);
+      break;
+    case EntityType::AsteroidSmall:
+      assign_type_tag<EntityType::AsteroidSmall>(a_registry, a_entity);
+      break;
+    case EntityType::AsteroidMedium:
+      assign_type_tag<EntityType::AsteroidMedium>(a_registry, a_entity);
+      break;
+    case EntityType::AsteroidBig:
+      assign_type_tag<EntityType::AsteroidBig>(a_registry, a_entity);
+      break;
+    case EntityType::LaserBeam:
+      assign_type_tag<EntityType::LaserBeam>(a_registry, a_entity);
+      break;
+    case EntityType::Player:
+      assign_type_tag<EntityType::Player>(a_registry, a_entity);
+      break;
+    case EntityType::Box:
+    case EntityType::Count:
+      break;
+  }
+}
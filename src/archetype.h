@@ -0,0 +1,78 @@
+#ifndef ARCHETYPE_H
+#define ARCHETYPE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include <entt/entt.hpp>
+
+#include "data_types.h"
+
+// What an entity type is at compile time. The update kernels are specialized on these,
+// so they can't come from config.json.
+struct ArchetypeTraits {
+  std::string_view name{};
+  std::string_view modelPath{};
+  bool asteroid{};
+  // integrated by updateEntities, the player has its own update
+  bool moves{};
+  bool rotates{};
+  bool accelerates{};
+};
+
+// per type values, config.json overrides the defaults below
+struct Archetype {
+  float scale{ 1.0f };
+  // only used when the model has no collision shape
+  float radius{ 1.0f };
+  int32_t points{};
+  int32_t fragments{};
+};
+
+// one empty component per type, so a view can iterate a single type
+template<EntityType Type>
+struct TypeTag {};
+
+constexpr std::array<ArchetypeTraits, static_cast<size_t>(EntityType::Count)> ARCHETYPE_TRAITS{ {
+  { "AsteroidFragment", "data/models/asteroid_fragment.obj", true, true, true, false },
+  { "AsteroidSmall", "data/models/asteroid_small.obj", true, true, true, false },
+  { "AsteroidMedium", "data/models/asteroid_medium.obj", true, true, true, false },
+  { "AsteroidBig", "data/models/asteroid_big.obj", true, true, true, false },
+  { "LaserBeam", "data/models/laser_beam.obj", false, true, false, false },
+  { "Player", "data/models/player.obj", false, false, false, false },
+  { "Box", "", false, false, false, false }
+} };
+
+constexpr std::array<Archetype, static_cast<size_t>(EntityType::Count)> DEFAULT_ARCHETYPES{ {
+  { 1.0f, 1.0f, 10, 0 },
+  { 1.0f, 1.4f, 25, 0 },
+  { 1.0f, 3.0f, 50, 2 },
+  { 1.0f, 3.5f, 100, 2 },
+  { 0.5f, 2.0f, 0, 0 },
+  { 1.0f, 1.8f, 0, 0 },
+  { 1.0f, 1.0f, 0, 0 }
+} };
+
+namespace Archetypes {
+
+  constexpr ArchetypeTraits const& get_traits(EntityType a_type)
+  {
+    return ARCHETYPE_TRAITS[static_cast<size_t>(a_type)];
+  }
+
+  constexpr bool is_asteroid(EntityType a_type)
+  {
+    return get_traits(a_type).asteroid;
+  }
+
+  // the type whose model is loaded from a_path
+  std::optional<EntityType> find_by_model(std::string_view a_path);
+
+  void assign_tag(entt::registry& a_registry, entt::entity a_entity, EntityType a_type);
+
+} // namespace Archetypes
+
+#endif //ARCHETYPE_H
@@ -0,0 +1,176 @@
+#include "asset_watcher.h"
+
+#include <chrono>
+#include <filesystem>
+#include <set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "log.h"
+#include "memory_tracker.h"
+#include "utils.h"
+
+namespace {
+
+// editors often save in several steps, give them a moment before reading
+constexpr auto SETTLE_TIME = std::chrono::milliseconds(50);
+constexpr int POLL_TIMEOUT_MS = 100;
+
+std::optional<AssetKind> get_asset_kind(std::filesystem::path const& a_path)
+{
+  auto const extension = a_path.extension();
+
+  if (extension == ".vert" || extension == ".frag")
+    return AssetKind::Shader;
+  if (extension == ".obj")
+    return AssetKind::Model;
+  if (extension == ".png" || extension == ".ktex")
+    return AssetKind::Texture;
+  if (extension == ".json")
+    return AssetKind::Config;
+
+  return {};
+}
+
+} // namespace
+
+AssetWatcher::~AssetWatcher()
+{
+  stop();
+}
+
+void AssetWatcher::start(std::vector<std::string> const& a_directories)
+{
+#ifdef __linux__
+  m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_inotify < 0) {
+    Log::assets().warn("cannot initialize inotify, hot reload disabled");
+    return;
+  }
+
+  for (auto const& directory : a_directories) {
+    int const watch = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0)
+      Log::assets().warn("cannot watch {}", directory);
+    else
+      m_watches[watch] = directory;
+  }
+
+  m_running = true;
+  m_thread = std::thread(&AssetWatcher::run, this);
+#else
+  Log::assets().info("hot reload is only supported on linux");
+#endif
+}
+
+void AssetWatcher::stop()
+{
+  m_running = false;
+
+  if (m_thread.joinable())
+    m_thread.join();
+
+#ifdef __linux__
+  if (m_inotify >= 0) {
+    close(m_inotify);
+    m_inotify = -1;
+  }
+#endif
+}
+
+std::vector<AssetChange> AssetWatcher::takeChanges()
+{
+  std::vector<AssetChange> changes{};
+
+  std::lock_guard lock{ m_mutex };
+  changes.swap(m_changes);
+  return changes;
+}
+
+void AssetWatcher::run()
+{
+#ifdef __linux__
+  alignas(inotify_event) char buffer[4096]{};
+
+  while (m_running) {
+    pollfd fd{ m_inotify, POLLIN, 0 };
+    if (poll(&fd, 1, POLL_TIMEOUT_MS) <= 0)
+      continue;
+
+    std::this_thread::sleep_for(SETTLE_TIME);
+
+    // coalesce everything that arrived in the meantime, one decode per file
+    std::set<std::string> paths{};
+
+    ssize_t length{};
+    while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+      for (char* ptr = buffer; ptr < buffer + length;) {
+        auto const* event = reinterpret_cast<inotify_event const*>(ptr);
+        auto const watch = m_watches.find(event->wd);
+
+        if (event->len > 0 && watch != m_watches.end())
+          paths.insert(watch->second + "/" + event->name);
+
+        ptr += sizeof(inotify_event) + event->len;
+      }
+    }
+
+    for (auto const& path : paths)
+      decode(path);
+  }
+#endif
+}
+
+void AssetWatcher::decode(std::string const& a_path)
+{
+  std::filesystem::path path{ a_path };
+
+  auto const kind = get_asset_kind(path);
+  if (!kind)
+    return;
+
+  Memory::TagScope scope{ Memory::Category::Assets };
+
+  AssetChange change{};
+  change.kind = *kind;
+  change.path = path.generic_string();
+
+  switch (*kind) {
+    case AssetKind::Shader:
+      break;
+    case AssetKind::Model:
+      change.model = Utils::read_model(change.path);
+      if (!change.model)
+        return;
+      break;
+    case AssetKind::Texture:
+      // textures are known by their source image, a fresh .ktex reloads the png entry
+      change.path = path.replace_extension(".png").generic_string();
+      change.texture = Utils::read_texture(change.path);
+      if (!change.texture)
+        return;
+      break;
+    case AssetKind::Config:
+      change.text = Utils::open_file(change.path);
+      if (!change.text)
+        return;
+      break;
+  }
+
+  Log::assets().info("Reloading {}", change.path);
+
+  std::lock_guard lock{ m_mutex };
+
+  for (auto& pending : m_changes) {
+    if (pending.path == change.path) {
+      pending = std::move(change);
+      return;
+    }
+  }
+
+  m_changes.push_back(std::move(change));
+}
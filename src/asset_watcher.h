@@ -0,0 +1,57 @@
+#ifndef ASSET_WATCHER_H
+#define ASSET_WATCHER_H
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "texture_cooker.h"
+
+enum class AssetKind {
+  Shader,
+  Model,
+  Texture,
+  Config
+};
+
+// A modified file, already decoded on the watcher thread. Only the member matching
+// kind is filled; shaders carry no payload because compiling needs the GL context.
+struct AssetChange {
+  AssetKind kind{};
+  std::string path{};
+  std::optional<std::vector<float>> model{};
+  std::optional<Cooker::CookedTexture> texture{};
+  std::optional<std::string> text{};
+};
+
+// Watches asset directories with inotify. Changes are decoded on a background thread
+// and handed to the main thread through takeChanges(), which is meant to be called
+// once per frame so GL objects are only ever swapped at a frame boundary.
+class AssetWatcher {
+public:
+  AssetWatcher() = default;
+  ~AssetWatcher();
+
+  void start(std::vector<std::string> const& a_directories);
+  void stop();
+
+  std::vector<AssetChange> takeChanges();
+
+private:
+  void run();
+  void decode(std::string const& a_path);
+
+  std::thread m_thread{};
+  std::atomic<bool> m_running{};
+  int m_inotify{ -1 };
+  std::unordered_map<int, std::string> m_watches{};
+
+  std::mutex m_mutex{};
+  std::vector<AssetChange> m_changes{};
+};
+
+#endif //ASSET_WATCHER_H
@@ -0,0 +1,160 @@
+#include "asteroid_field.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "random.h"
+#include "spawn_scheduler.h"
+#include "utils.h"
+
+namespace {
+
+constexpr uint32_t MAX_ASTEROIDS_PER_CHUNK = 4096;
+constexpr float MIN_FORWARD_VELOCITY = 0.1f;
+
+} // namespace
+
+void AsteroidField::reset(uint64_t a_seed, float a_startZ, CorridorSettings const& a_settings)
+{
+  m_worker.wait();
+  m_generating = false;
+  m_generated.clear();
+
+  m_settings = a_settings;
+  m_settings.chunkLength = std::max(m_settings.chunkLength, 1.0f);
+  m_seed = a_seed;
+  m_startZ = a_startZ + m_settings.startDistance;
+  m_nextActivation = getChunkIndex(m_startZ);
+  m_nextGeneration = m_nextActivation;
+  m_ready.clear();
+  m_active.clear();
+}
+
+std::optional<AsteroidChunk> AsteroidField::takeActivation(float a_playerZ, ChunkDensity const& a_density)
+{
+  if (m_generating && !m_worker.isBusy())
+    collect();
+
+  int64_t const activationLine = getChunkIndex(a_playerZ + m_settings.activateDistance);
+
+  if (!m_generating)
+    generate(activationLine + static_cast<int64_t>(m_settings.lookahead), a_density);
+
+  if (m_nextActivation > activationLine)
+    return {};
+
+  while (m_ready.empty() || m_ready.front().index != m_nextActivation) {
+    // the worker fell behind a fast player, the chunk is needed now
+    if (m_generating) {
+      m_worker.wait();
+      collect();
+    } else {
+      generate(activationLine + static_cast<int64_t>(m_settings.lookahead), a_density);
+    }
+  }
+
+  AsteroidChunk chunk{ std::move(m_ready.front()) };
+  m_ready.pop_front();
+  m_active.push_back(chunk.index);
+  ++m_nextActivation;
+
+  return chunk;
+}
+
+std::optional<float> AsteroidField::takeRetirement(float a_playerZ)
+{
+  if (m_active.empty())
+    return {};
+
+  float const end = static_cast<float>(m_active.front() + 1) * m_settings.chunkLength;
+  if (end > a_playerZ - m_settings.retireDistance)
+    return {};
+
+  m_active.pop_front();
+  return end;
+}
+
+float AsteroidField::getFarZ() const
+{
+  return static_cast<float>(m_nextGeneration) * m_settings.chunkLength;
+}
+
+int64_t AsteroidField::getChunkIndex(float a_z) const
+{
+  return static_cast<int64_t>(std::floor(a_z / m_settings.chunkLength));
+}
+
+uint32_t AsteroidField::getCount(int64_t a_index, ChunkDensity const& a_density) const
+{
+  float const velocity = std::max(a_density.forwardVelocity, MIN_FORWARD_VELOCITY);
+  float const chunkStart = std::max(static_cast<float>(a_index) * m_settings.chunkLength, m_startZ);
+
+  // the rate when the player gets there, over the time it takes to cross the chunk
+  float const time = (chunkStart - m_startZ) / velocity;
+  float const rate = std::max(0.0f, a_density.rate + a_density.rateIncrease * time);
+  float const count = std::round(rate * m_settings.chunkLength / velocity);
+
+  return static_cast<uint32_t>(std::min(count, static_cast<float>(MAX_ASTEROIDS_PER_CHUNK)));
+}
+
+void AsteroidField::generate(int64_t a_last, ChunkDensity const& a_density)
+{
+  if (m_nextGeneration > a_last)
+    return;
+
+  // counts are decided here, so a density change never races with the worker
+  std::vector<Request> requests{};
+  for (int64_t index = m_nextGeneration; index <= a_last; ++index)
+    requests.push_back({ index, getCount(index, a_density), m_startZ });
+
+  m_nextGeneration = a_last + 1;
+  m_generating = true;
+
+  m_worker.run([this, requests = std::move(requests), seed = m_seed, settings = m_settings] {
+    m_generated.resize(requests.size());
+
+    for (size_t i = 0; i < requests.size(); ++i)
+      generateChunk(requests[i], seed, settings, m_generated[i]);
+  });
+}
+
+void AsteroidField::collect()
+{
+  for (auto& chunk : m_generated)
+    m_ready.push_back(std::move(chunk));
+
+  m_generated.clear();
+  m_generating = false;
+}
+
+void AsteroidField::generateChunk(Request const& a_request, uint64_t a_seed, CorridorSettings const& a_settings,
+  AsteroidChunk& a_chunk)
+{
+  Random random{ Utils::fnv1a(&a_request.index, sizeof(a_request.index), a_seed) };
+
+  float const halfWidth = a_settings.width * 0.5f;
+  float const minZ = std::max(static_cast<float>(a_request.index) * a_settings.chunkLength, a_request.minZ);
+  float const maxZ = static_cast<float>(a_request.index + 1) * a_settings.chunkLength;
+
+  a_chunk.index = a_request.index;
+  a_chunk.types.resize(a_request.count);
+  a_chunk.positions.resize(a_request.count);
+  a_chunk.rotationAxes.resize(a_request.count);
+  a_chunk.rotationVelocities.resize(a_request.count);
+
+  // one draw per statement, argument evaluation order is unspecified
+  for (uint32_t i = 0; i < a_request.count; ++i) {
+    a_chunk.types[i] = static_cast<EntityType>(random.range(static_cast<uint32_t>(EntityType::AsteroidFragment),
+      static_cast<uint32_t>(EntityType::AsteroidBig)));
+
+    float const posX = random.range(-halfWidth, halfWidth);
+    float const posZ = random.range(minZ, maxZ);
+    float const axisX = random.range(-1.0f, 1.0f);
+    float const axisY = random.range(-1.0f, 1.0f);
+    float const axisZ = random.range(-1.0f, 1.0f);
+
+    a_chunk.positions[i] = glm::vec3(posX, 0.0f, posZ);
+    a_chunk.rotationAxes[i] = glm::vec3(axisX, axisY, axisZ);
+    a_chunk.rotationVelocities[i] = random.range(ASTEROID_ANGLE_VELOCITY_MIN, ASTEROID_ANGLE_VELOCITY_MAX);
+  }
+}
@@ -0,0 +1,89 @@
+#ifndef ASTEROID_FIELD_H
+#define ASTEROID_FIELD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "data_types.h"
+#include "job_system.h"
+
+struct CorridorSettings {
+  float chunkLength{ 30.0f };
+  float width{ 40.0f };
+  // no asteroids closer than this to where a game starts
+  float startDistance{ 40.0f };
+  // a chunk enters the registry once its start is this far ahead of the player
+  float activateDistance{ 70.0f };
+  // and leaves it once its end is this far behind
+  float retireDistance{ 10.0f };
+  // chunks generated in the background beyond the activation line
+  uint32_t lookahead{ 3 };
+};
+
+// spawn rate in asteroids per second at the start of a game, growing by rateIncrease
+// every second, converted to a count per chunk through the forward velocity
+struct ChunkDensity {
+  float rate{};
+  float rateIncrease{};
+  float forwardVelocity{};
+};
+
+struct AsteroidChunk {
+  int64_t index{};
+  std::vector<EntityType> types{};
+  std::vector<glm::vec3> positions{};
+  std::vector<glm::vec3> rotationAxes{};
+  std::vector<float> rotationVelocities{};
+};
+
+// Splits the play space along +z into chunks of fixed length. The content of a chunk only
+// depends on the seed and its index, so chunks are generated ahead of time on a worker and
+// a game plays out the same no matter when the worker got to them.
+class AsteroidField {
+public:
+  void reset(uint64_t a_seed, float a_startZ, CorridorSettings const& a_settings);
+
+  // the next chunk the player reached, waits for the worker when it fell behind
+  std::optional<AsteroidChunk> takeActivation(float a_playerZ, ChunkDensity const& a_density);
+  // the end of the oldest active chunk once it is behind the player
+  std::optional<float> takeRetirement(float a_playerZ);
+
+  float getFarZ() const;
+  size_t getActiveCount() const { return m_active.size(); }
+  size_t getReadyCount() const { return m_ready.size(); }
+
+private:
+  struct Request {
+    int64_t index{};
+    uint32_t count{};
+    float minZ{};
+  };
+
+  int64_t getChunkIndex(float a_z) const;
+  uint32_t getCount(int64_t a_index, ChunkDensity const& a_density) const;
+  void generate(int64_t a_last, ChunkDensity const& a_density);
+  void collect();
+
+  static void generateChunk(Request const& a_request, uint64_t a_seed, CorridorSettings const& a_settings,
+    AsteroidChunk& a_chunk);
+
+  CorridorSettings m_settings{};
+  uint64_t m_seed{};
+  float m_startZ{};
+  int64_t m_nextActivation{};
+  int64_t m_nextGeneration{};
+  std::deque<AsteroidChunk> m_ready{};
+  std::deque<int64_t> m_active{};
+
+  // owned by the worker while m_generating is set
+  std::vector<AsteroidChunk> m_generated{};
+  bool m_generating{};
+  WorkerThread m_worker{};
+};
+
+#endif //ASTEROID_FIELD_H
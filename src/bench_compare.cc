@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace {
+
+constexpr double DEFAULT_THRESHOLD_PERCENT = 5.0;
+constexpr double DEFAULT_NOISE_FACTOR = 3.0;
+constexpr size_t WORST_OFFENDERS = 5;
+
+// scales a MAD to the standard deviation of normally distributed samples
+constexpr double MAD_TO_SIGMA = 1.4826;
+
+enum class Verdict {
+  Unchanged,
+  Faster,
+  Slower,
+  Added,
+  Removed
+};
+
+struct Measurement {
+  double median{};
+  double mad{};
+};
+
+struct Comparison {
+  std::string name{};
+  std::optional<Measurement> baseline{};
+  std::optional<Measurement> current{};
+  double deltaPercent{};
+  double noisePercent{};
+  Verdict verdict{};
+};
+
+std::optional<std::map<std::string, Measurement>> read_results(std::string const& a_path)
+{
+  using json = nlohmann::json;
+
+  std::ifstream file{ a_path };
+  if (!file) {
+    std::cerr << "cannot open " << a_path << std::endl;
+    return {};
+  }
+
+  std::stringstream buffer{};
+  buffer << file.rdbuf();
+
+  json root{ json::parse(buffer.str(), nullptr, false) };
+  if (root.is_discarded() || !root.contains("benchmarks")) {
+    std::cerr << "invalid benchmark results " << a_path << std::endl;
+    return {};
+  }
+
+  std::map<std::string, Measurement> results{};
+
+  try {
+    for (auto const& benchmark : root["benchmarks"]) {
+      Measurement measurement{};
+      measurement.median = benchmark["median"].get<double>();
+      measurement.mad = benchmark["mad"].get<double>();
+      results[benchmark["name"].get<std::string>()] = measurement;
+    }
+  } catch (json::exception const& e) {
+    std::cerr << "invalid benchmark results " << a_path << ": " << e.what() << std::endl;
+    return {};
+  }
+
+  return results;
+}
+
+// A change only counts when it is bigger than the requested percentage and also
+// bigger than the spread both runs showed between their own repetitions.
+Comparison compare(std::string const& a_name, std::optional<Measurement> a_baseline,
+  std::optional<Measurement> a_current, double a_thresholdPercent, double a_noiseFactor)
+{
+  Comparison comparison{};
+  comparison.name = a_name;
+  comparison.baseline = a_baseline;
+  comparison.current = a_current;
+
+  if (!a_baseline) {
+    comparison.verdict = Verdict::Added;
+    return comparison;
+  }
+
+  if (!a_current) {
+    comparison.verdict = Verdict::Removed;
+    return comparison;
+  }
+
+  if (a_baseline->median <= 0.0) {
+    comparison.verdict = Verdict::Unchanged;
+    return comparison;
+  }
+
+  double const noise = a_noiseFactor * MAD_TO_SIGMA * std::hypot(a_baseline->mad, a_current->mad);
+
+  comparison.deltaPercent = (a_current->median - a_baseline->median) / a_baseline->median * 100.0;
+  comparison.noisePercent = noise / a_baseline->median * 100.0;
+
+  double const limit = std::max(a_thresholdPercent, comparison.noisePercent);
+
+  if (comparison.deltaPercent > limit)
+    comparison.verdict = Verdict::Slower;
+  else if (comparison.deltaPercent < -limit)
+    comparison.verdict = Verdict::Faster;
+  else
+    comparison.verdict = Verdict::Unchanged;
+
+  return comparison;
+}
+
+std::string_view get_verdict_name(Verdict a_verdict)
+{
+  switch (a_verdict) {
+    case Verdict::Unchanged:
+      return "";
+    case Verdict::Faster:
+      return "faster";
+    case Verdict::Slower:
+      return "REGRESSION";
+    case Verdict::Added:
+      return "added";
+    case Verdict::Removed:
+      return "removed";
+  }
+
+  return "";
+}
+
+std::string format_time(std::optional<Measurement> const& a_measurement)
+{
+  if (!a_measurement)
+    return "-";
+
+  static constexpr char const* units[]{ "ns", "us", "ms", "s" };
+
+  double value = a_measurement->median;
+  size_t unit{};
+  while (value >= 1000.0 && unit + 1 < std::size(units)) {
+    value /= 1000.0;
+    ++unit;
+  }
+
+  char buffer[32]{};
+  std::snprintf(buffer, sizeof(buffer), "%.2f %s", value, units[unit]);
+  return buffer;
+}
+
+std::string format_percent(double a_percent, bool a_sign)
+{
+  char buffer[32]{};
+  std::snprintf(buffer, sizeof(buffer), a_sign ? "%+.1f%%" : "%.1f%%", a_percent);
+  return buffer;
+}
+
+void print_table(std::vector<Comparison> const& a_comparisons)
+{
+  size_t nameWidth{ 4 };
+  for (auto const& comparison : a_comparisons)
+    nameWidth = std::max(nameWidth, comparison.name.size());
+
+  std::printf("%-*s %14s %14s %9s %9s  %s\n", static_cast<int>(nameWidth), "case", "baseline", "current", "delta",
+    "noise", "");
+
+  for (auto const& comparison : a_comparisons) {
+    bool const compared = comparison.baseline && comparison.current;
+
+    std::printf("%-*s %14s %14s %9s %9s  %s\n", static_cast<int>(nameWidth), comparison.name.c_str(),
+      format_time(comparison.baseline).c_str(), format_time(comparison.current).c_str(),
+      compared ? format_percent(comparison.deltaPercent, true).c_str() : "-",
+      compared ? format_percent(comparison.noisePercent, false).c_str() : "-",
+      get_verdict_name(comparison.verdict).data());
+  }
+}
+
+void print_usage()
+{
+  std::cerr << "usage: BenchCompare <baseline.json> <current.json> [--threshold <percent>] [--noise <factor>]"
+    << std::endl;
+}
+
+} // namespace
+
+// Usage: BenchCompare <baseline.json> <current.json> [--threshold <percent>] [--noise <factor>]
+// Compares two SpaceshipBenchmarks result files case by case. A case regresses when its
+// median got slower by more than --threshold percent and by more than --noise times the
+// combined MAD of both runs. Exits with 1 on a regression and 2 when a file can't be read.
+int main(int argc, char **argv)
+{
+  std::vector<std::string> paths{};
+  double thresholdPercent{ DEFAULT_THRESHOLD_PERCENT };
+  double noiseFactor{ DEFAULT_NOISE_FACTOR };
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg{ argv[i] };
+    bool const hasValue = i + 1 < argc;
+
+    // stod throws invalid_argument and out_of_range, both are logic_errors
+    try {
+      if (arg == "--threshold" && hasValue)
+        thresholdPercent = std::stod(argv[++i]);
+      else if (arg == "--noise" && hasValue)
+        noiseFactor = std::stod(argv[++i]);
+      else
+        paths.push_back(arg);
+    }
+    catch (std::logic_error const&) {
+      std::cerr << "invalid value " << argv[i] << " for " << arg << std::endl;
+      print_usage();
+      return 2;
+    }
+  }
+
+  if (paths.size() != 2) {
+    print_usage();
+    return 2;
+  }
+
+  auto const baseline = read_results(paths[0]);
+  auto const current = read_results(paths[1]);
+  if (!baseline || !current)
+    return 2;
+
+  std::vector<Comparison> comparisons{};
+
+  for (auto const& [name, measurement] : *baseline) {
+    auto const found = current->find(name);
+    auto const other = found != current->end() ? std::optional<Measurement>{ found->second } : std::nullopt;
+    comparisons.push_back(compare(name, measurement, other, thresholdPercent, noiseFactor));
+  }
+
+  for (auto const& [name, measurement] : *current) {
+    if (baseline->find(name) == baseline->end())
+      comparisons.push_back(compare(name, std::nullopt, measurement, thresholdPercent, noiseFactor));
+  }
+
+  print_table(comparisons);
+
+  std::vector<Comparison const*> regressions{};
+  for (auto const& comparison : comparisons) {
+    if (comparison.verdict == Verdict::Slower)
+      regressions.push_back(&comparison);
+  }
+
+  std::sort(regressions.begin(), regressions.end(), [](auto const* a_lhs, auto const* a_rhs) {
+    return a_lhs->deltaPercent > a_rhs->deltaPercent;
+  });
+
+  std::printf("\n");
+
+  if (regressions.empty()) {
+    std::printf("no regressions beyond %.1f%% (%zu cases)\n", thresholdPercent, comparisons.size());
+    return EXIT_SUCCESS;
+  }
+
+  std::printf("%zu regressions beyond %.1f%%, worst offenders:\n", regressions.size(), thresholdPercent);
+  for (size_t i = 0; i < std::min(regressions.size(), WORST_OFFENDERS); ++i) {
+    auto const& comparison = *regressions[i];
+    std::printf("  %s %s (%s -> %s)\n", comparison.name.c_str(), format_percent(comparison.deltaPercent, true).c_str(),
+      format_time(comparison.baseline).c_str(), format_time(comparison.current).c_str());
+  }
+
+  return EXIT_FAILURE;
+}
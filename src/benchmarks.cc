@@ -0,0 +1,622 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "game.h"
+#include "log.h"
+#include "utils.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// a sample is long enough once the clock resolution and loop overhead stop mattering
+constexpr auto MIN_SAMPLE_TIME = std::chrono::milliseconds(10);
+constexpr uint64_t MAX_ITERATIONS = 1ull << 24;
+constexpr int DEFAULT_REPETITIONS = 9;
+
+constexpr float BENCHMARK_DELTA = 1.0f / 60.0f;
+constexpr uint64_t BENCHMARK_SEED = 1;
+
+// more than a laser's collision diameter, neighbouring shots of a volley never pair up
+constexpr float LASER_SPACING = 5.0f;
+
+constexpr uint32_t FRAGMENTATION_ASTEROIDS = 2000;
+constexpr uint32_t FRAGMENTATION_TICKS = 600;
+
+constexpr uint32_t CORRIDOR_TICKS = 3600;
+constexpr uint32_t CORRIDOR_SHOT_INTERVAL = 8;
+
+// five minutes of spawning and destroying, then updates and collisions are timed on their own
+constexpr uint32_t AGED_TICKS = 18000;
+constexpr uint32_t AGED_MEASURED_TICKS = 600;
+
+// the lane in front of the player is cleared after a while, rebuild the scene in between
+constexpr uint64_t HITSCAN_SHOTS_PER_SCENE = 64;
+
+// quadratic, larger scenes would take minutes per sample
+constexpr size_t MAX_BRUTE_FORCE_ENTITIES = 10000;
+
+// Runs the measured body a_iterations times and returns the elapsed nanoseconds.
+// Anything that has to happen before every iteration is kept out of the total.
+using BenchmarkFunction = std::function<uint64_t(uint64_t a_iterations)>;
+
+struct Benchmark {
+  std::string name{};
+  BenchmarkFunction run{};
+};
+
+struct Result {
+  std::string name{};
+  uint64_t iterations{};
+  std::vector<double> samples{};
+  double median{};
+  double mad{};
+  double min{};
+};
+
+// Scenarios that run the game tick by tick and care about the worst frame rather than
+// a typical iteration. They run once, there is nothing to calibrate.
+struct StressResult {
+  std::string name{};
+  uint32_t ticks{};
+  double meanMs{};
+  double worstMs{};
+  size_t peakEntities{};
+  // mean per call, only measured by the aged scenarios
+  double updateMs{};
+  double collisionMs{};
+};
+
+struct Stress {
+  std::string name{};
+  std::function<StressResult()> run{};
+};
+
+uint64_t elapsed_ns(Clock::time_point a_start)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - a_start).count());
+}
+
+double get_median(std::vector<double> a_values)
+{
+  if (a_values.empty())
+    return 0.0;
+
+  std::sort(a_values.begin(), a_values.end());
+
+  size_t const middle = a_values.size() / 2;
+  if (a_values.size() % 2 == 0)
+    return (a_values[middle - 1] + a_values[middle]) * 0.5;
+
+  return a_values[middle];
+}
+
+// median absolute deviation, robust against the odd sample hit by a context switch
+double get_mad(std::vector<double> const& a_values, double a_median)
+{
+  std::vector<double> deviations{};
+  deviations.reserve(a_values.size());
+
+  for (auto value : a_values)
+    deviations.push_back(std::abs(value - a_median));
+
+  return get_median(deviations);
+}
+
+uint64_t calibrate(Benchmark const& a_benchmark)
+{
+  uint64_t const minTime = std::chrono::duration_cast<std::chrono::nanoseconds>(MIN_SAMPLE_TIME).count();
+
+  uint64_t iterations{ 1 };
+  while (iterations < MAX_ITERATIONS) {
+    uint64_t const time = a_benchmark.run(iterations);
+    if (time >= minTime)
+      break;
+
+    // jump close to the target instead of doubling blindly, but never more than 10x
+    uint64_t const scale = time > 0 ? minTime * 12 / 10 / time + 1 : 10;
+    iterations *= std::clamp<uint64_t>(scale, 2, 10);
+  }
+
+  return std::min(iterations, MAX_ITERATIONS);
+}
+
+Result measure(Benchmark const& a_benchmark, int a_repetitions)
+{
+  Result result{};
+  result.name = a_benchmark.name;
+  result.iterations = calibrate(a_benchmark);
+
+  for (int i = 0; i < a_repetitions; ++i) {
+    uint64_t const time = a_benchmark.run(result.iterations);
+    result.samples.push_back(static_cast<double>(time) / result.iterations);
+  }
+
+  result.median = get_median(result.samples);
+  result.mad = get_mad(result.samples, result.median);
+  result.min = *std::min_element(result.samples.begin(), result.samples.end());
+
+  return result;
+}
+
+// the game spawns asteroids in front of the player and lasers at its position,
+// keep the same mix as a busy game: mostly asteroids, some lasers in flight
+void populate(Game& a_game, size_t a_entities)
+{
+  a_game.reset();
+  a_game.beginFrame();
+
+  // spaced along their path as if fired one after another, shot from one point every
+  // laser would pair with every other one and drown out the asteroids
+  size_t const lasers = a_entities / 10;
+  for (size_t i = 0; i < lasers; ++i)
+    a_game.shoot(static_cast<float>(i) * LASER_SPACING);
+  a_game.applyCommands();
+
+  a_game.spawnAsteroids(static_cast<uint32_t>(a_entities - lasers));
+  a_game.applyCommands();
+
+  a_game.updateEntities(BENCHMARK_DELTA);
+}
+
+uint64_t run_check_collision(Game& a_game, size_t a_entities, uint64_t a_iterations)
+{
+  // checkCollision destroys what it hits, rebuild the scene before every pass
+  uint64_t total{};
+  for (uint64_t i = 0; i < a_iterations; ++i) {
+    populate(a_game, a_entities);
+
+    auto const start = Clock::now();
+    a_game.checkCollision();
+    a_game.applyCommands();
+    total += elapsed_ns(start);
+  }
+  return total;
+}
+
+void add_game_benchmarks(std::vector<Benchmark>& a_benchmarks, Game& a_game)
+{
+  // the broadphase from config.json
+  BroadphaseKind const broadphase{ a_game.getBroadphase() };
+
+  for (size_t entities : { 100, 1000, 10000, 100000 }) {
+    a_benchmarks.push_back({ "checkCollision/" + std::to_string(entities), [&a_game, broadphase, entities](uint64_t a_iterations) {
+      a_game.setBroadphase(broadphase);
+      return run_check_collision(a_game, entities, a_iterations);
+    } });
+  }
+
+  for (size_t i = 0; i < static_cast<size_t>(BroadphaseKind::Count); ++i) {
+    auto const kind = static_cast<BroadphaseKind>(i);
+
+    for (size_t entities : { 100, 1000, 10000, 100000 }) {
+      if (kind == BroadphaseKind::BruteForce && entities > MAX_BRUTE_FORCE_ENTITIES)
+        continue;
+
+      std::string name{ "broadphase/" };
+      name += get_broadphase_name(kind);
+      name += "/" + std::to_string(entities);
+
+      a_benchmarks.push_back({ name, [&a_game, kind, entities](uint64_t a_iterations) {
+        a_game.setBroadphase(kind);
+        return run_check_collision(a_game, entities, a_iterations);
+      } });
+    }
+  }
+
+  for (size_t entities : { 1000, 10000, 100000 }) {
+    a_benchmarks.push_back({ "hitscan/" + std::to_string(entities), [&a_game, entities](uint64_t a_iterations) {
+      a_game.setHitscan(true);
+
+      uint64_t total{};
+      for (uint64_t i = 0; i < a_iterations; i += HITSCAN_SHOTS_PER_SCENE) {
+        populate(a_game, entities);
+        a_game.updateAsteroidTree();
+
+        auto const start = Clock::now();
+        for (uint64_t j = i; j < std::min(a_iterations, i + HITSCAN_SHOTS_PER_SCENE); ++j)
+          a_game.shoot();
+        total += elapsed_ns(start);
+      }
+
+      a_game.setHitscan(false);
+      return total;
+    } });
+  }
+
+  for (size_t entities : { 100, 1000, 10000, 100000 }) {
+    a_benchmarks.push_back({ "updateEntities/" + std::to_string(entities), [&a_game, entities](uint64_t a_iterations) {
+      populate(a_game, entities);
+
+      auto const start = Clock::now();
+      for (uint64_t i = 0; i < a_iterations; ++i)
+        a_game.updateEntities(BENCHMARK_DELTA);
+      return elapsed_ns(start);
+    } });
+
+    // culling and matrices for what is left, the part of a frame after the simulation
+    a_benchmarks.push_back({ "renderPrep/" + std::to_string(entities), [&a_game, entities](uint64_t a_iterations) {
+      populate(a_game, entities);
+
+      RenderSnapshot snapshot{};
+
+      auto const start = Clock::now();
+      for (uint64_t i = 0; i < a_iterations; ++i)
+        a_game.buildSnapshot(snapshot);
+      return elapsed_ns(start);
+    } });
+  }
+
+  // all asteroids in the spawn window, far denser than regular play
+  for (size_t entities : { 1000, 5000, 10000 }) {
+    a_benchmarks.push_back({ "resolveAsteroidContacts/" + std::to_string(entities), [&a_game, entities](uint64_t a_iterations) {
+      uint64_t total{};
+      for (uint64_t i = 0; i < a_iterations; ++i) {
+        populate(a_game, entities);
+
+        auto const start = Clock::now();
+        a_game.resolveAsteroidContacts();
+        total += elapsed_ns(start);
+      }
+      return total;
+    } });
+  }
+
+  for (size_t burst : { 10, 100, 1000 }) {
+    a_benchmarks.push_back({ "spawnAsteroid/" + std::to_string(burst), [&a_game, burst](uint64_t a_iterations) {
+      uint64_t total{};
+      for (uint64_t i = 0; i < a_iterations; ++i) {
+        a_game.reset();
+        a_game.beginFrame();
+
+        auto const start = Clock::now();
+        for (size_t j = 0; j < burst; ++j)
+          a_game.spawnAsteroid();
+        a_game.applyCommands();
+        total += elapsed_ns(start);
+      }
+      return total;
+    } });
+
+    a_benchmarks.push_back({ "spawnAsteroids/" + std::to_string(burst), [&a_game, burst](uint64_t a_iterations) {
+      uint64_t total{};
+      for (uint64_t i = 0; i < a_iterations; ++i) {
+        a_game.reset();
+        a_game.beginFrame();
+
+        auto const start = Clock::now();
+        a_game.spawnAsteroids(static_cast<uint32_t>(burst));
+        a_game.applyCommands();
+        total += elapsed_ns(start);
+      }
+      return total;
+    } });
+  }
+
+  if (auto config = Utils::open_file("data/configs/config.json")) {
+    a_benchmarks.push_back({ "loadSettings", [&a_game, config = *config](uint64_t a_iterations) {
+      auto const start = Clock::now();
+      for (uint64_t i = 0; i < a_iterations; ++i)
+        a_game.loadSettings(config);
+      uint64_t const time = elapsed_ns(start);
+
+      // the config turns logging back on
+      Log::setEnabled(false);
+      return time;
+    } });
+  }
+}
+
+// Ticks the game like the headless mode does, shooting every a_shotInterval ticks, until
+// a_ticks have passed or the player got hit.
+StressResult run_scripted(Game& a_game, uint32_t a_ticks, uint32_t a_shotInterval)
+{
+  StressResult result{};
+  double total{};
+
+  for (uint32_t i = 0; i < a_ticks && a_game.isPlaying(); ++i) {
+    auto const start = Clock::now();
+
+    a_game.beginFrame();
+    if (i % a_shotInterval == 0)
+      a_game.shoot();
+    a_game.tick(BENCHMARK_DELTA);
+
+    double const time = static_cast<double>(elapsed_ns(start)) / 1e6;
+    total += time;
+
+    result.worstMs = std::max(result.worstMs, time);
+    result.peakEntities = std::max(result.peakEntities, a_game.getEntityCount());
+    ++result.ticks;
+  }
+
+  result.meanMs = result.ticks > 0 ? total / result.ticks : 0.0;
+  return result;
+}
+
+// A dense field straight ahead of the player and a laser every tick, every hit splits
+// the asteroid and the fragments get shot in turn.
+StressResult run_fragmentation_stress(Game& a_game)
+{
+  a_game.reset();
+  a_game.beginFrame();
+
+  a_game.spawnAsteroids(FRAGMENTATION_ASTEROIDS);
+  a_game.applyCommands();
+
+  return run_scripted(a_game, FRAGMENTATION_TICKS, 1);
+}
+
+// A regular game along the streamed corridor, firing at a fixed interval instead of input.
+StressResult run_corridor_stress(Game& a_game)
+{
+  a_game.reset();
+
+  return run_scripted(a_game, CORRIDOR_TICKS, CORRIDOR_SHOT_INTERVAL);
+}
+
+// The corridor scenario for long enough that spawning, fragmenting and retiring have
+// scattered the storage, then updateEntities and checkCollision are timed one by one.
+StressResult run_aged_stress(Game& a_game, bool a_spatialSort)
+{
+  bool const spatialSort{ a_game.getSpatialSort() };
+  a_game.setSpatialSort(a_spatialSort);
+  a_game.reset();
+
+  StressResult result{ run_scripted(a_game, AGED_TICKS, CORRIDOR_SHOT_INTERVAL) };
+
+  double update{};
+  double collision{};
+
+  for (uint32_t i = 0; i < AGED_MEASURED_TICKS; ++i) {
+    a_game.beginFrame();
+
+    auto start = Clock::now();
+    a_game.updateEntities(BENCHMARK_DELTA);
+    update += static_cast<double>(elapsed_ns(start)) / 1e6;
+
+    start = Clock::now();
+    a_game.checkCollision();
+    a_game.applyCommands();
+    collision += static_cast<double>(elapsed_ns(start)) / 1e6;
+  }
+
+  result.updateMs = update / AGED_MEASURED_TICKS;
+  result.collisionMs = collision / AGED_MEASURED_TICKS;
+
+  a_game.setSpatialSort(spatialSort);
+  return result;
+}
+
+void add_stress(std::vector<Stress>& a_stress, Game& a_game)
+{
+  for (size_t i = 0; i < static_cast<size_t>(BroadphaseKind::Count); ++i) {
+    auto const kind = static_cast<BroadphaseKind>(i);
+    std::string const suffix{ get_broadphase_name(kind) };
+
+    a_stress.push_back({ "stress/fragmentation/" + suffix, [&a_game, kind]() {
+      a_game.setBroadphase(kind);
+      return run_fragmentation_stress(a_game);
+    } });
+
+    a_stress.push_back({ "stress/corridor/" + suffix, [&a_game, kind]() {
+      a_game.setBroadphase(kind);
+      return run_corridor_stress(a_game);
+    } });
+  }
+
+  // a shot every tick without a single laser entity
+  a_stress.push_back({ "stress/hitscan", [&a_game]() {
+    a_game.setHitscan(true);
+    a_game.reset();
+    auto const result = run_scripted(a_game, CORRIDOR_TICKS, 1);
+    a_game.setHitscan(false);
+    return result;
+  } });
+
+  a_stress.push_back({ "stress/aged/sorted", [&a_game]() { return run_aged_stress(a_game, true); } });
+  a_stress.push_back({ "stress/aged/unsorted", [&a_game]() { return run_aged_stress(a_game, false); } });
+}
+
+// Parsing only: uploading the vertices needs a GL context, which the benchmarks don't create.
+void add_model_benchmarks(std::vector<Benchmark>& a_benchmarks)
+{
+  std::vector<std::string> paths{};
+
+  std::error_code error{};
+  for (auto const& entry : std::filesystem::directory_iterator("data/models", error)) {
+    if (entry.path().extension() == ".obj")
+      paths.push_back(entry.path().generic_string());
+  }
+
+  std::sort(paths.begin(), paths.end());
+
+  for (auto const& path : paths) {
+    auto const name = std::filesystem::path(path).filename().string();
+
+    a_benchmarks.push_back({ "read_model/" + name, [path](uint64_t a_iterations) {
+      auto const start = Clock::now();
+      for (uint64_t i = 0; i < a_iterations; ++i) {
+        auto model = Utils::read_model(path);
+        if (!model)
+          return uint64_t{};
+      }
+      return elapsed_ns(start);
+    } });
+  }
+}
+
+nlohmann::json to_json(std::vector<Result> const& a_results, std::vector<StressResult> const& a_stressResults,
+  int a_repetitions)
+{
+  using json = nlohmann::json;
+
+  json context{};
+  context["date"] = static_cast<int64_t>(std::chrono::duration_cast<std::chrono::seconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count());
+  context["repetitions"] = a_repetitions;
+  context["hardware_concurrency"] = std::thread::hardware_concurrency();
+#ifdef NDEBUG
+  context["build_type"] = "release";
+#else
+  context["build_type"] = "debug";
+#endif
+
+  json benchmarks = json::array();
+  for (auto const& result : a_results) {
+    json benchmark{};
+    benchmark["name"] = result.name;
+    benchmark["unit"] = "ns";
+    benchmark["iterations"] = result.iterations;
+    benchmark["samples"] = result.samples;
+    benchmark["median"] = result.median;
+    benchmark["mad"] = result.mad;
+    benchmark["min"] = result.min;
+    benchmarks.push_back(benchmark);
+  }
+
+  json stress = json::array();
+  for (auto const& result : a_stressResults) {
+    json scenario{};
+    scenario["name"] = result.name;
+    scenario["ticks"] = result.ticks;
+    scenario["mean_ms"] = result.meanMs;
+    scenario["worst_ms"] = result.worstMs;
+    scenario["peak_entities"] = result.peakEntities;
+    if (result.updateMs > 0.0 || result.collisionMs > 0.0) {
+      scenario["update_ms"] = result.updateMs;
+      scenario["collision_ms"] = result.collisionMs;
+    }
+    stress.push_back(scenario);
+  }
+
+  json root{};
+  root["context"] = context;
+  root["benchmarks"] = benchmarks;
+  root["stress"] = stress;
+  return root;
+}
+
+void print_usage()
+{
+  std::cerr << "usage: SpaceshipBenchmarks [--filter <substring>] [--repetitions <n>] [--out <file.json>]"
+    << std::endl;
+}
+
+} // namespace
+
+// Usage: SpaceshipBenchmarks [--filter <substring>] [--repetitions <n>] [--out <file.json>]
+// Must be started from the solution root so data/ resolves. Every case reports the time
+// per iteration in nanoseconds, stress scenarios their mean and worst tick in milliseconds;
+// the JSON goes to stdout unless --out is given.
+int main(int argc, char **argv)
+{
+  Log::init();
+
+  std::string filter{};
+  std::string outPath{};
+  int repetitions{ DEFAULT_REPETITIONS };
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg{ argv[i] };
+    bool const hasValue = i + 1 < argc;
+
+    // stoi throws invalid_argument and out_of_range, both are logic_errors
+    try {
+      if (arg == "--filter" && hasValue)
+        filter = argv[++i];
+      else if (arg == "--repetitions" && hasValue)
+        repetitions = std::max(1, std::stoi(argv[++i]));
+      else if (arg == "--out" && hasValue)
+        outPath = argv[++i];
+      else
+        Log::game().warn("unknown argument {}", arg);
+    }
+    catch (std::logic_error const&) {
+      Log::game().error("invalid value {} for {}", argv[i], arg);
+      print_usage();
+      Log::shutdown();
+      return 2;
+    }
+  }
+
+  std::vector<Result> results{};
+  std::vector<StressResult> stressResults{};
+
+  {
+    Options options{};
+    options.seed = BENCHMARK_SEED;
+    options.headless = true;
+
+    Game game{ options };
+    Log::setEnabled(false);
+
+    std::vector<Benchmark> benchmarks{};
+    add_game_benchmarks(benchmarks, game);
+    add_model_benchmarks(benchmarks);
+
+    for (auto const& benchmark : benchmarks) {
+      if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+        continue;
+
+      results.push_back(measure(benchmark, repetitions));
+
+      auto const& result = results.back();
+      std::cerr << result.name << ": " << result.median << " ns +- " << result.mad
+        << " (" << result.iterations << " iterations)" << std::endl;
+    }
+
+    std::vector<Stress> stress{};
+    add_stress(stress, game);
+
+    for (auto const& scenario : stress) {
+      if (!filter.empty() && scenario.name.find(filter) == std::string::npos)
+        continue;
+
+      stressResults.push_back(scenario.run());
+      stressResults.back().name = scenario.name;
+
+      auto const& result = stressResults.back();
+      std::cerr << result.name << ": worst " << result.worstMs << " ms, mean " << result.meanMs << " ms over "
+        << result.ticks << " ticks, peak " << result.peakEntities << " entities" << std::endl;
+
+      if (result.updateMs > 0.0 || result.collisionMs > 0.0) {
+        std::cerr << "  aged storage: update " << result.updateMs << " ms, collision " << result.collisionMs << " ms"
+          << std::endl;
+      }
+    }
+  }
+
+  Log::setEnabled(true);
+
+  auto const output = to_json(results, stressResults, repetitions).dump(2);
+
+  int exitCode{ EXIT_SUCCESS };
+
+  if (outPath.empty()) {
+    std::cout << output << std::endl;
+  } else {
+    std::ofstream file{ outPath };
+    file << output << std::endl;
+    if (!file) {
+      Log::game().error("cannot write {}", outPath);
+      exitCode = EXIT_FAILURE;
+    }
+  }
+
+  Log::shutdown();
+  return exitCode;
+}
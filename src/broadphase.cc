@@ -0,0 +1,150 @@
+#include "broadphase.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool Broadphase::overlaps(BroadphaseProxy const& a_lhs, BroadphaseProxy const& a_rhs)
+{
+  float const extent = a_lhs.radius + a_rhs.radius;
+
+  return std::abs(a_lhs.position.x - a_rhs.position.x) <= extent &&
+    std::abs(a_lhs.position.y - a_rhs.position.y) <= extent &&
+    std::abs(a_lhs.position.z - a_rhs.position.z) <= extent;
+}
+
+void BruteForceBroadphase::findPairs(BroadphaseProxy const* a_proxies, size_t a_count,
+  FrameVector<BroadphasePair>& a_pairs)
+{
+  for (size_t i = 0; i < a_count; ++i) {
+    for (size_t j = i + 1; j < a_count; ++j) {
+      if (overlaps(a_proxies[i], a_proxies[j]))
+        a_pairs.emplace_back(static_cast<uint32_t>(i), static_cast<uint32_t>(j));
+    }
+  }
+}
+
+void SweepAndPruneBroadphase::findPairs(BroadphaseProxy const* a_proxies, size_t a_count,
+  FrameVector<BroadphasePair>& a_pairs)
+{
+  for (size_t i = 0; i < a_count; ++i) {
+    uint32_t const key = a_proxies[i].key;
+    if (key >= m_slots.size())
+      m_slots.resize(static_cast<size_t>(key) + 1);
+
+    m_slots[key] = static_cast<uint32_t>(i) + 1;
+  }
+
+  // survivors keep last call's order, newcomers go to the end; clearing the slots on the
+  // way leaves them ready for the next call
+  m_sorted.clear();
+
+  for (uint32_t const key : m_order) {
+    if (key < m_slots.size() && m_slots[key] != 0) {
+      m_sorted.push_back(m_slots[key] - 1);
+      m_slots[key] = 0;
+    }
+  }
+
+  for (size_t i = 0; i < a_count; ++i) {
+    uint32_t& slot = m_slots[a_proxies[i].key];
+    if (slot != 0) {
+      m_sorted.push_back(static_cast<uint32_t>(i));
+      slot = 0;
+    }
+  }
+
+  auto const minZ = [a_proxies](uint32_t a_index) {
+    return a_proxies[a_index].position.z - a_proxies[a_index].radius;
+  };
+
+  m_swaps = 0;
+
+  for (size_t i = 1; i < m_sorted.size(); ++i) {
+    uint32_t const index = m_sorted[i];
+    float const z = minZ(index);
+
+    size_t j = i;
+    for (; j > 0 && minZ(m_sorted[j - 1]) > z; --j)
+      m_sorted[j] = m_sorted[j - 1];
+
+    m_sorted[j] = index;
+    m_swaps += i - j;
+  }
+
+  m_order.resize(m_sorted.size());
+  for (size_t i = 0; i < m_sorted.size(); ++i)
+    m_order[i] = a_proxies[m_sorted[i]].key;
+
+  for (size_t i = 0; i < m_sorted.size(); ++i) {
+    auto const& proxy = a_proxies[m_sorted[i]];
+    float const maxZ = proxy.position.z + proxy.radius;
+
+    for (size_t j = i + 1; j < m_sorted.size() && minZ(m_sorted[j]) <= maxZ; ++j) {
+      if (!overlaps(proxy, a_proxies[m_sorted[j]]))
+        continue;
+
+      a_pairs.emplace_back(std::min(m_sorted[i], m_sorted[j]), std::max(m_sorted[i], m_sorted[j]));
+    }
+  }
+}
+
+void GridBroadphase::findPairs(BroadphaseProxy const* a_proxies, size_t a_count,
+  FrameVector<BroadphasePair>& a_pairs)
+{
+  float maxRadius{};
+  m_positions.resize(a_count);
+
+  for (size_t i = 0; i < a_count; ++i) {
+    m_positions[i] = a_proxies[i].position;
+    maxRadius = std::max(maxRadius, a_proxies[i].radius);
+  }
+
+  m_grid.build(m_positions.data(), a_count, maxRadius * 2.0f);
+
+  m_grid.forEachPair([&](uint32_t a_lhs, uint32_t a_rhs) {
+    if (overlaps(a_proxies[a_lhs], a_proxies[a_rhs]))
+      a_pairs.emplace_back(std::min(a_lhs, a_rhs), std::max(a_lhs, a_rhs));
+  });
+}
+
+std::unique_ptr<Broadphase> create_broadphase(BroadphaseKind a_kind)
+{
+  switch (a_kind) {
+    case BroadphaseKind::BruteForce:
+      return std::make_unique<BruteForceBroadphase>();
+    case BroadphaseKind::SweepAndPrune:
+      return std::make_unique<SweepAndPruneBroadphase>();
+    case BroadphaseKind::Grid:
+    case BroadphaseKind::Count:
+      break;
+  }
+
+  return std::make_unique<GridBroadphase>();
+}
+
+std::string_view get_broadphase_name(BroadphaseKind a_kind)
+{
+  switch (a_kind) {
+    case BroadphaseKind::BruteForce:
+      return "bruteForce";
+    case BroadphaseKind::SweepAndPrune:
+      return "sweepAndPrune";
+    case BroadphaseKind::Grid:
+      return "grid";
+    case BroadphaseKind::Count:
+      break;
+  }
+
+  return "";
+}
+
+std::optional<BroadphaseKind> get_broadphase_kind(std::string_view a_name)
+{
+  for (size_t i = 0; i < static_cast<size_t>(BroadphaseKind::Count); ++i) {
+    auto const kind = static_cast<BroadphaseKind>(i);
+    if (get_broadphase_name(kind) == a_name)
+      return kind;
+  }
+
+  return {};
+}
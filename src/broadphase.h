@@ -0,0 +1,91 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "debug_draw.h"
+#include "frame_arena.h"
+#include "spatial_grid.h"
+
+enum class BroadphaseKind {
+  BruteForce,
+  SweepAndPrune,
+  Grid,
+  Count
+};
+
+struct BroadphaseProxy {
+  glm::vec3 position{};
+  float radius{};
+  // identifies the same body from one call to the next, unique within a call
+  uint32_t key{};
+};
+
+// indices into the proxies, first < second
+using BroadphasePair = std::pair<uint32_t, uint32_t>;
+
+// Finds the pairs of proxies whose bounding boxes overlap. The pairs are a superset of the
+// touching spheres, the caller runs the exact test. Their order differs per implementation.
+class Broadphase {
+public:
+  virtual ~Broadphase() = default;
+
+  virtual BroadphaseKind getKind() const = 0;
+  virtual void findPairs(BroadphaseProxy const* a_proxies, size_t a_count, FrameVector<BroadphasePair>& a_pairs) = 0;
+  // the structure the last findPairs built, if there is anything to see
+  virtual void drawDebug(DebugDraw& a_draw) const {}
+
+protected:
+  static bool overlaps(BroadphaseProxy const& a_lhs, BroadphaseProxy const& a_rhs);
+};
+
+// every pair, the reference the others are checked against
+class BruteForceBroadphase : public Broadphase {
+public:
+  BroadphaseKind getKind() const override { return BroadphaseKind::BruteForce; }
+  void findPairs(BroadphaseProxy const* a_proxies, size_t a_count, FrameVector<BroadphasePair>& a_pairs) override;
+};
+
+// Sweep and prune along z, the axis everything flies along. The order of the last call is
+// kept by key and repaired with an insertion sort, which is close to linear as long as
+// bodies move little between calls.
+class SweepAndPruneBroadphase : public Broadphase {
+public:
+  BroadphaseKind getKind() const override { return BroadphaseKind::SweepAndPrune; }
+  void findPairs(BroadphaseProxy const* a_proxies, size_t a_count, FrameVector<BroadphasePair>& a_pairs) override;
+
+  size_t getLastSwapCount() const { return m_swaps; }
+
+private:
+  std::vector<uint32_t> m_order{};
+  // proxy index + 1 by key during a call, 0 otherwise
+  std::vector<uint32_t> m_slots{};
+  std::vector<uint32_t> m_sorted{};
+  size_t m_swaps{};
+};
+
+// uniform grid sized by the largest proxy, see SpatialGrid
+class GridBroadphase : public Broadphase {
+public:
+  BroadphaseKind getKind() const override { return BroadphaseKind::Grid; }
+  void findPairs(BroadphaseProxy const* a_proxies, size_t a_count, FrameVector<BroadphasePair>& a_pairs) override;
+  void drawDebug(DebugDraw& a_draw) const override { m_grid.drawDebug(a_draw, 0.0f, DebugDraw::BLUE); }
+
+private:
+  std::vector<glm::vec3> m_positions{};
+  SpatialGrid m_grid{};
+};
+
+std::unique_ptr<Broadphase> create_broadphase(BroadphaseKind a_kind);
+std::string_view get_broadphase_name(BroadphaseKind a_kind);
+std::optional<BroadphaseKind> get_broadphase_kind(std::string_view a_name);
+
+#endif //BROADPHASE_H
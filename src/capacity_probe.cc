@@ -0,0 +1,139 @@
+#include "capacity_probe.h"
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "log.h"
+
+namespace {
+
+// nearest rank on sorted samples
+double get_percentile(std::vector<float> const& a_sorted, double a_percentile)
+{
+  if (a_sorted.empty())
+    return 0.0;
+
+  auto const rank = static_cast<size_t>(a_percentile / 100.0 * static_cast<double>(a_sorted.size() - 1) + 0.5);
+  return a_sorted[std::min(rank, a_sorted.size() - 1)];
+}
+
+} // namespace
+
+CapacityProbe::CapacityProbe(CapacitySettings const& a_settings, bool a_headless)
+  : m_settings{ a_settings }
+  , m_headless{ a_headless }
+{
+  m_settings.bucketSize = std::max<uint32_t>(m_settings.bucketSize, 1);
+}
+
+bool CapacityProbe::record(size_t a_entities, double a_frameMs)
+{
+  if (m_finished)
+    return false;
+
+  m_samples.push_back(static_cast<float>(a_frameMs));
+
+  size_t const bucket = a_entities / m_settings.bucketSize * m_settings.bucketSize;
+  if (bucket > m_bucketStart && m_samples.size() >= m_settings.minSamples) {
+    closeBucket();
+    m_bucketStart = bucket;
+  }
+
+  if (!m_finished && a_entities >= m_settings.maxEntities) {
+    Log::game().info("Capacity scenario reached {} entities without missing the budget", a_entities);
+    m_finished = true;
+  }
+
+  return !m_finished;
+}
+
+void CapacityProbe::closeBucket()
+{
+  std::sort(m_samples.begin(), m_samples.end());
+
+  Bucket bucket{};
+  bucket.entities = m_bucketStart;
+  bucket.frames = m_samples.size();
+  bucket.p50 = get_percentile(m_samples, 50.0);
+  bucket.p95 = get_percentile(m_samples, 95.0);
+  bucket.p99 = get_percentile(m_samples, 99.0);
+  bucket.max = m_samples.back();
+  m_buckets.push_back(bucket);
+
+  m_samples.clear();
+
+  Log::game().info("Capacity {} entities: p50 {:.2f} ms, p99 {:.2f} ms", bucket.entities, bucket.p50, bucket.p99);
+
+  if (bucket.p99 > m_settings.budgetMs) {
+    Log::game().info("Capacity scenario over budget at {} entities ({:.2f} > {:.2f} ms)", bucket.entities,
+      bucket.p99, m_settings.budgetMs);
+    m_finished = true;
+  }
+}
+
+size_t CapacityProbe::getCapacity() const
+{
+  size_t capacity{};
+
+  for (auto const& bucket : m_buckets) {
+    if (bucket.p99 > m_settings.budgetMs)
+      break;
+    capacity = bucket.entities + m_settings.bucketSize;
+  }
+
+  return capacity;
+}
+
+bool CapacityProbe::write(std::string const& a_basePath) const
+{
+  using json = nlohmann::json;
+
+  std::ofstream csv{ a_basePath + ".csv" };
+  csv << "entities,frames,p50_ms,p95_ms,p99_ms,max_ms\n";
+  for (auto const& bucket : m_buckets) {
+    csv << bucket.entities << "," << bucket.frames << "," << bucket.p50 << "," << bucket.p95 << ","
+      << bucket.p99 << "," << bucket.max << "\n";
+  }
+
+  json context{};
+  context["budget_ms"] = m_settings.budgetMs;
+  context["bucket_size"] = m_settings.bucketSize;
+  context["ramp_rate"] = m_settings.rampRate;
+  context["headless"] = m_headless;
+  context["hardware_concurrency"] = std::thread::hardware_concurrency();
+#ifdef NDEBUG
+  context["build_type"] = "release";
+#else
+  context["build_type"] = "debug";
+#endif
+
+  json buckets = json::array();
+  for (auto const& bucket : m_buckets) {
+    json entry{};
+    entry["entities"] = bucket.entities;
+    entry["frames"] = bucket.frames;
+    entry["p50_ms"] = bucket.p50;
+    entry["p95_ms"] = bucket.p95;
+    entry["p99_ms"] = bucket.p99;
+    entry["max_ms"] = bucket.max;
+    buckets.push_back(entry);
+  }
+
+  json root{};
+  root["context"] = context;
+  root["capacity"] = getCapacity();
+  root["buckets"] = buckets;
+
+  std::ofstream file{ a_basePath + ".json" };
+  file << root.dump(2) << std::endl;
+
+  if (!csv || !file) {
+    Log::game().error("cannot write capacity results to {}", a_basePath);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,55 @@
+#ifndef CAPACITY_PROBE_H
+#define CAPACITY_PROBE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CapacitySettings {
+  float budgetMs{ 16.7f };
+  uint32_t bucketSize{ 250 };
+  // asteroids per second added to the spawn rate every second
+  float rampRate{ 20.0f };
+  uint32_t maxEntities{ 100000 };
+  uint32_t minSamples{ 60 };
+};
+
+// Frame times bucketed by entity count for the capacity scenario (--capacity). A bucket
+// closes once the entity count moved past it and enough frames were seen, and the run
+// ends with the first bucket whose p99 misses the frame budget.
+class CapacityProbe {
+public:
+  CapacityProbe(CapacitySettings const& a_settings, bool a_headless);
+
+  // false once the scenario is over
+  bool record(size_t a_entities, double a_frameMs);
+
+  // writes <a_basePath>.csv and <a_basePath>.json
+  bool write(std::string const& a_basePath) const;
+
+  // largest entity count whose bucket stayed within the budget
+  size_t getCapacity() const;
+
+private:
+  struct Bucket {
+    size_t entities{};
+    size_t frames{};
+    double p50{};
+    double p95{};
+    double p99{};
+    double max{};
+  };
+
+  void closeBucket();
+
+  CapacitySettings m_settings{};
+  bool m_headless{};
+  bool m_finished{};
+
+  size_t m_bucketStart{};
+  std::vector<float> m_samples{};
+  std::vector<Bucket> m_buckets{};
+};
+
+#endif //CAPACITY_PROBE_H
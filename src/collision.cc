@@ -0,0 +1,404 @@
+#include "collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <tuple>
+#include <utility>
+
+#include <glm/glm.hpp>
+
+namespace {
+
+constexpr int GJK_MAX_ITERATIONS = 32;
+
+struct Sphere {
+  glm::vec3 center{};
+  float radius{ -1.0f };
+
+  bool contains(glm::vec3 const& a_point) const
+  {
+    return radius >= 0.0f && glm::length(a_point - center) <= radius * (1.0f + 1e-5f) + 1e-6f;
+  }
+};
+
+Sphere sphere_from(glm::vec3 const& a_a, glm::vec3 const& a_b)
+{
+  glm::vec3 const center{ (a_a + a_b) * 0.5f };
+  return { center, glm::length(a_a - center) };
+}
+
+// circumscribed spheres, falling back to the widest pair when the points are degenerate
+Sphere sphere_from(glm::vec3 const& a_a, glm::vec3 const& a_b, glm::vec3 const& a_c)
+{
+  glm::vec3 const ab{ a_b - a_a };
+  glm::vec3 const ac{ a_c - a_a };
+  glm::vec3 const normal{ glm::cross(ab, ac) };
+  float const denominator = 2.0f * glm::dot(normal, normal);
+
+  if (denominator < 1e-12f) {
+    Sphere sphere{ sphere_from(a_a, a_b) };
+    for (auto const& candidate : { sphere_from(a_a, a_c), sphere_from(a_b, a_c) }) {
+      if (candidate.radius > sphere.radius)
+        sphere = candidate;
+    }
+    return sphere;
+  }
+
+  glm::vec3 const offset{ glm::cross(ab * glm::dot(ac, ac) - ac * glm::dot(ab, ab), normal) / denominator };
+  return { a_a - offset, glm::length(offset) };
+}
+
+Sphere sphere_from(glm::vec3 const& a_a, glm::vec3 const& a_b, glm::vec3 const& a_c, glm::vec3 const& a_d)
+{
+  glm::vec3 const ab{ a_b - a_a };
+  glm::vec3 const ac{ a_c - a_a };
+  glm::vec3 const ad{ a_d - a_a };
+  float const denominator = 2.0f * glm::dot(ab, glm::cross(ac, ad));
+
+  if (std::abs(denominator) < 1e-12f) {
+    Sphere sphere{ sphere_from(a_a, a_b, a_c) };
+    for (auto const& candidate : { sphere_from(a_a, a_b, a_d), sphere_from(a_a, a_c, a_d), sphere_from(a_b, a_c, a_d) }) {
+      if (candidate.radius > sphere.radius)
+        sphere = candidate;
+    }
+    return sphere;
+  }
+
+  glm::vec3 const offset{ (glm::cross(ac, ad) * glm::dot(ab, ab) + glm::cross(ad, ab) * glm::dot(ac, ac) +
+    glm::cross(ab, ac) * glm::dot(ad, ad)) / denominator };
+  return { a_a + offset, glm::length(offset) };
+}
+
+Sphere sphere_from(std::vector<glm::vec3> const& a_boundary)
+{
+  switch (a_boundary.size()) {
+    case 0:
+      return {};
+    case 1:
+      return { a_boundary[0], 0.0f };
+    case 2:
+      return sphere_from(a_boundary[0], a_boundary[1]);
+    case 3:
+      return sphere_from(a_boundary[0], a_boundary[1], a_boundary[2]);
+    default:
+      return sphere_from(a_boundary[0], a_boundary[1], a_boundary[2], a_boundary[3]);
+  }
+}
+
+// Welzl's algorithm, exact for the small point counts of a hull
+Sphere welzl(std::vector<glm::vec3> const& a_points, size_t a_count, std::vector<glm::vec3>& a_boundary)
+{
+  if (a_count == 0 || a_boundary.size() == 4)
+    return sphere_from(a_boundary);
+
+  glm::vec3 const point{ a_points[a_count - 1] };
+  Sphere sphere{ welzl(a_points, a_count - 1, a_boundary) };
+
+  if (sphere.contains(point))
+    return sphere;
+
+  a_boundary.push_back(point);
+  sphere = welzl(a_points, a_count - 1, a_boundary);
+  a_boundary.pop_back();
+
+  return sphere;
+}
+
+struct Face {
+  int a{};
+  int b{};
+  int c{};
+  glm::vec3 normal{};
+  float offset{};
+};
+
+Face make_face(std::vector<glm::vec3> const& a_points, int a_a, int a_b, int a_c)
+{
+  Face face{ a_a, a_b, a_c };
+  face.normal = glm::normalize(glm::cross(a_points[a_b] - a_points[a_a], a_points[a_c] - a_points[a_a]));
+  face.offset = glm::dot(face.normal, a_points[a_a]);
+  return face;
+}
+
+// The point of the hull furthest along a_direction, in world space. For a transform
+// M = [A | t] that is A * argmax(dot(v, transpose(A) * d)) + t.
+glm::vec3 support(CollisionShape const& a_shape, glm::mat4 const& a_transform, glm::vec3 const& a_direction)
+{
+  glm::vec3 const local{ glm::transpose(glm::mat3(a_transform)) * a_direction };
+
+  glm::vec3 best{ a_shape.hull.front() };
+  float bestDistance{ glm::dot(best, local) };
+
+  for (auto const& vertex : a_shape.hull) {
+    float const distance = glm::dot(vertex, local);
+    if (distance > bestDistance) {
+      best = vertex;
+      bestDistance = distance;
+    }
+  }
+
+  return glm::vec3(a_transform * glm::vec4(best, 1.0f));
+}
+
+// Reduces the simplex to the feature closest to the origin and points a_direction at the
+// origin from there. The newest point is always the last one. True once the origin is
+// enclosed.
+bool update_simplex(glm::vec3* a_simplex, int& a_count, glm::vec3& a_direction)
+{
+  // points are taken by value, they alias the simplex being rewritten
+  auto const line = [&](glm::vec3 a_b, glm::vec3 a_a) {
+    glm::vec3 const ab{ a_b - a_a };
+    glm::vec3 const ao{ -a_a };
+
+    if (glm::dot(ab, ao) > 0.0f) {
+      a_simplex[0] = a_b;
+      a_simplex[1] = a_a;
+      a_count = 2;
+      a_direction = glm::cross(glm::cross(ab, ao), ab);
+    } else {
+      a_simplex[0] = a_a;
+      a_count = 1;
+      a_direction = ao;
+    }
+  };
+
+  auto const triangle = [&](glm::vec3 a_c, glm::vec3 a_b, glm::vec3 a_a) {
+    glm::vec3 const ab{ a_b - a_a };
+    glm::vec3 const ac{ a_c - a_a };
+    glm::vec3 const ao{ -a_a };
+    glm::vec3 const abc{ glm::cross(ab, ac) };
+
+    if (glm::dot(glm::cross(abc, ac), ao) > 0.0f) {
+      if (glm::dot(ac, ao) > 0.0f) {
+        a_simplex[0] = a_c;
+        a_simplex[1] = a_a;
+        a_count = 2;
+        a_direction = glm::cross(glm::cross(ac, ao), ac);
+      } else {
+        line(a_b, a_a);
+      }
+    } else if (glm::dot(glm::cross(ab, abc), ao) > 0.0f) {
+      line(a_b, a_a);
+    } else if (glm::dot(abc, ao) > 0.0f) {
+      a_simplex[0] = a_c;
+      a_simplex[1] = a_b;
+      a_simplex[2] = a_a;
+      a_count = 3;
+      a_direction = abc;
+    } else {
+      // keep the winding so the tetrahedron case can rely on outward normals
+      a_simplex[0] = a_b;
+      a_simplex[1] = a_c;
+      a_simplex[2] = a_a;
+      a_count = 3;
+      a_direction = -abc;
+    }
+  };
+
+  switch (a_count) {
+    case 2:
+      line(a_simplex[0], a_simplex[1]);
+      return false;
+    case 3:
+      triangle(a_simplex[0], a_simplex[1], a_simplex[2]);
+      return false;
+    default:
+      break;
+  }
+
+  glm::vec3 const d{ a_simplex[0] };
+  glm::vec3 const c{ a_simplex[1] };
+  glm::vec3 const b{ a_simplex[2] };
+  glm::vec3 const a{ a_simplex[3] };
+  glm::vec3 const ao{ -a };
+
+  if (glm::dot(glm::cross(b - a, c - a), ao) > 0.0f) {
+    triangle(c, b, a);
+    return false;
+  }
+
+  if (glm::dot(glm::cross(c - a, d - a), ao) > 0.0f) {
+    triangle(d, c, a);
+    return false;
+  }
+
+  if (glm::dot(glm::cross(d - a, b - a), ao) > 0.0f) {
+    triangle(b, d, a);
+    return false;
+  }
+
+  return true;
+}
+
+} // namespace
+
+CollisionShape Collision::build_shape(std::vector<float> const& a_vertices, size_t a_stride)
+{
+  CollisionShape shape{};
+
+  std::vector<glm::vec3> points{};
+  points.reserve(a_vertices.size() / a_stride);
+
+  for (size_t i = 0; i + 2 < a_vertices.size(); i += a_stride)
+    points.emplace_back(a_vertices[i], a_vertices[i + 1], a_vertices[i + 2]);
+
+  if (points.empty())
+    return shape;
+
+  shape.hull = convex_hull(points);
+
+  // the sphere is defined by hull vertices alone
+  std::vector<glm::vec3> boundary{};
+  Sphere const sphere{ welzl(shape.hull, shape.hull.size(), boundary) };
+
+  shape.center = sphere.center;
+  shape.radius = 0.0f;
+  for (auto const& point : shape.hull)
+    shape.radius = std::max(shape.radius, glm::length(point - shape.center));
+
+  if (shape.hull.size() < 4)
+    shape.hull.clear();
+
+  return shape;
+}
+
+// Incremental hull: start from a tetrahedron, then every point outside replaces the faces
+// it sees with a fan to the horizon. Quadratic, which is fine for game meshes.
+std::vector<glm::vec3> Collision::convex_hull(std::vector<glm::vec3> const& a_input)
+{
+  std::vector<glm::vec3> points{ a_input };
+  std::sort(points.begin(), points.end(), [](glm::vec3 const& a_lhs, glm::vec3 const& a_rhs) {
+    return std::tie(a_lhs.x, a_lhs.y, a_lhs.z) < std::tie(a_rhs.x, a_rhs.y, a_rhs.z);
+  });
+  points.erase(std::unique(points.begin(), points.end(), [](glm::vec3 const& a_lhs, glm::vec3 const& a_rhs) {
+    return a_lhs.x == a_rhs.x && a_lhs.y == a_rhs.y && a_lhs.z == a_rhs.z;
+  }), points.end());
+
+  if (points.size() < 4)
+    return points;
+
+  auto const farthest = [&](auto&& a_distance) {
+    int best{};
+    for (int i = 1; i < static_cast<int>(points.size()); ++i) {
+      if (a_distance(points[i]) > a_distance(points[best]))
+        best = i;
+    }
+    return best;
+  };
+
+  int const i0{ 0 };
+  int const i1{ farthest([&](glm::vec3 const& a_point) { return glm::length(a_point - points[i0]); }) };
+  float const extent{ glm::length(points[i1] - points[i0]) };
+  float const epsilon{ extent * 1e-5f };
+
+  glm::vec3 const axis{ glm::normalize(points[i1] - points[i0]) };
+  int const i2{ farthest([&](glm::vec3 const& a_point) {
+    return glm::length(glm::cross(a_point - points[i0], axis)); }) };
+
+  glm::vec3 const normal{ glm::normalize(glm::cross(points[i1] - points[i0], points[i2] - points[i0])) };
+  int const i3{ farthest([&](glm::vec3 const& a_point) {
+    return std::abs(glm::dot(a_point - points[i0], normal)); }) };
+
+  if (extent <= 0.0f || std::abs(glm::dot(points[i3] - points[i0], normal)) <= epsilon)
+    return points;
+
+  std::vector<Face> faces{};
+
+  // wind every face of the tetrahedron so its normal points away from the opposite corner
+  int const corners[4]{ i0, i1, i2, i3 };
+  for (int opposite = 0; opposite < 4; ++opposite) {
+    int face[3]{};
+    for (int i = 0, j = 0; i < 4; ++i) {
+      if (i != opposite)
+        face[j++] = corners[i];
+    }
+
+    Face candidate{ make_face(points, face[0], face[1], face[2]) };
+    if (glm::dot(candidate.normal, points[corners[opposite]]) > candidate.offset)
+      candidate = make_face(points, face[0], face[2], face[1]);
+
+    faces.push_back(candidate);
+  }
+
+  for (int p = 0; p < static_cast<int>(points.size()); ++p) {
+    if (p == i0 || p == i1 || p == i2 || p == i3)
+      continue;
+
+    std::set<std::pair<int, int>> visibleEdges{};
+    std::vector<Face> kept{};
+
+    for (auto const& face : faces) {
+      if (glm::dot(face.normal, points[p]) - face.offset > epsilon) {
+        visibleEdges.insert({ face.a, face.b });
+        visibleEdges.insert({ face.b, face.c });
+        visibleEdges.insert({ face.c, face.a });
+      } else {
+        kept.push_back(face);
+      }
+    }
+
+    if (visibleEdges.empty())
+      continue;
+
+    // an edge seen from one side only is on the horizon
+    for (auto const& [a, b] : visibleEdges) {
+      if (visibleEdges.count({ b, a }) == 0)
+        kept.push_back(make_face(points, a, b, p));
+    }
+
+    faces.swap(kept);
+  }
+
+  std::vector<bool> used(points.size());
+  for (auto const& face : faces)
+    used[face.a] = used[face.b] = used[face.c] = true;
+
+  std::vector<glm::vec3> hull{};
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (used[i])
+      hull.push_back(points[i]);
+  }
+
+  return hull;
+}
+
+bool Collision::intersect(CollisionShape const& a_lhs, glm::mat4 const& a_lhsTransform, CollisionShape const& a_rhs,
+  glm::mat4 const& a_rhsTransform)
+{
+  if (a_lhs.hull.empty() || a_rhs.hull.empty())
+    return true;
+
+  // a point of the Minkowski difference lhs - rhs, which contains the origin on overlap
+  auto const minkowski = [&](glm::vec3 const& a_direction) {
+    return support(a_lhs, a_lhsTransform, a_direction) - support(a_rhs, a_rhsTransform, -a_direction);
+  };
+
+  glm::vec3 direction{ glm::vec3(a_rhsTransform[3]) - glm::vec3(a_lhsTransform[3]) };
+  if (glm::dot(direction, direction) < 1e-12f)
+    direction = glm::vec3(1.0f, 0.0f, 0.0f);
+
+  glm::vec3 simplex[4]{};
+  int count{ 1 };
+
+  simplex[0] = minkowski(direction);
+  direction = -simplex[0];
+
+  for (int i = 0; i < GJK_MAX_ITERATIONS; ++i) {
+    // the origin lies on the simplex
+    if (glm::dot(direction, direction) < 1e-12f)
+      return true;
+
+    glm::vec3 const point{ minkowski(direction) };
+    if (glm::dot(point, direction) < 0.0f)
+      return false;
+
+    simplex[count++] = point;
+
+    if (update_simplex(simplex, count, direction))
+      return true;
+  }
+
+  // out of iterations only on touching contact, which counts as a hit
+  return true;
+}
@@ -0,0 +1,43 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+// collision geometry of a model, in model space
+struct CollisionShape {
+  // smallest sphere around all vertices
+  glm::vec3 center{};
+  float radius{};
+  // vertices of the convex hull, empty when the mesh is flat or too small for one
+  std::vector<glm::vec3> hull{};
+};
+
+// how far the pairs of one tick got through the narrowphase tiers
+struct NarrowphaseStats {
+  uint32_t broadphasePairs{};
+  uint32_t spherePairs{};
+  uint32_t hullPairs{};
+  uint32_t hits{};
+};
+
+namespace Collision {
+
+  // a_vertices as uploaded to the GPU, a_stride floats per vertex starting with the position
+  CollisionShape build_shape(std::vector<float> const& a_vertices, size_t a_stride = 5);
+
+  // hull vertices of a_points, which may keep points lying on a hull face;
+  // the deduplicated a_points when they don't span a volume
+  std::vector<glm::vec3> convex_hull(std::vector<glm::vec3> const& a_points);
+
+  // GJK on both hulls placed by their model matrices (rotation, uniform scale, translation)
+  bool intersect(CollisionShape const& a_lhs, glm::mat4 const& a_lhsTransform, CollisionShape const& a_rhs,
+    glm::mat4 const& a_rhsTransform);
+
+} // namespace Collision
+
+#endif //COLLISION_H
@@ -0,0 +1,126 @@
+#include "command_buffer.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "archetype.h"
+#include "memory_tracker.h"
+
+PendingEntity CommandBuffer::Recorder::create()
+{
+  m_commands.push_back({ CommandType::Create, entt::null, m_creates });
+  return { m_creates++ };
+}
+
+void CommandBuffer::Recorder::destroy(entt::entity a_entity)
+{
+  uint32_t const key = get_entity_key(a_entity);
+  if (key >= m_destroyed.size())
+    m_destroyed.resize(static_cast<size_t>(key) + 1);
+
+  if (m_destroyed[key])
+    return;
+
+  m_destroyed[key] = true;
+  m_destroyedKeys.push_back(key);
+  m_commands.push_back({ CommandType::Destroy, a_entity });
+}
+
+bool CommandBuffer::Recorder::isDestroyed(entt::entity a_entity) const
+{
+  uint32_t const key = get_entity_key(a_entity);
+  return key < m_destroyed.size() && m_destroyed[key];
+}
+
+void CommandBuffer::Recorder::clear()
+{
+  for (auto const key : m_destroyedKeys)
+    m_destroyed[key] = false;
+
+  m_destroyedKeys.clear();
+  m_commands.clear();
+  m_creates = 0;
+}
+
+void CommandBuffer::setLaneCount(size_t a_lanes)
+{
+  m_lanes.resize(std::max<size_t>(a_lanes, 1));
+}
+
+void CommandBuffer::apply(entt::registry& a_registry)
+{
+  using clock_t = std::chrono::high_resolution_clock;
+  using duration = std::chrono::duration<double, std::milli>;
+
+  auto const start = clock_t::now();
+
+  size_t commands{};
+  uint32_t creates{};
+  for (auto const& lane : m_lanes) {
+    commands += lane.m_commands.size();
+    creates += lane.m_creates;
+  }
+
+  if (commands == 0)
+    return;
+
+  Memory::TagScope scope{ Memory::Category::Registry };
+
+  if (creates > 0)
+    a_registry.reserve<Physics, Model, Texture>(a_registry.size<Physics>() + creates);
+
+  for (auto& lane : m_lanes) {
+    m_created.clear();
+
+    for (auto const& command : lane.m_commands) {
+      switch (command.type) {
+        case Recorder::CommandType::Create:
+          m_created.push_back(a_registry.create());
+          break;
+        case Recorder::CommandType::Assign: {
+          auto const entity = command.entity == entt::null ? m_created[command.pending] : command.entity;
+          if (!a_registry.valid(entity))
+            break;
+
+          std::visit([&](auto const& a_component) {
+            using Component = std::decay_t<decltype(a_component)>;
+
+            if constexpr (std::is_same_v<Component, Physics>) {
+              a_registry.assign_or_replace<Physics>(entity, a_component);
+              Archetypes::assign_tag(a_registry, entity, a_component.entityType);
+            } else if constexpr (!std::is_same_v<Component, std::monostate>) {
+              a_registry.assign_or_replace<Component>(entity, a_component);
+            }
+          }, command.payload);
+          break;
+        }
+        case Recorder::CommandType::Destroy:
+          // two lanes may have destroyed the same entity
+          if (a_registry.valid(command.entity))
+            a_registry.destroy(command.entity);
+          break;
+      }
+    }
+
+    lane.clear();
+  }
+
+  duration const applyTime = clock_t::now() - start;
+
+  m_stats.commands += static_cast<uint32_t>(commands);
+  ++m_stats.applies;
+  m_stats.applyMs += applyTime.count();
+}
+
+void CommandBuffer::clear()
+{
+  for (auto& lane : m_lanes)
+    lane.clear();
+}
+
+CommandStats CommandBuffer::takeStats()
+{
+  CommandStats const stats{ m_stats };
+  m_stats = {};
+  return stats;
+}
@@ -0,0 +1,107 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "data_types.h"
+
+// the entity without its version, stable for as long as the entity lives
+inline uint32_t get_entity_key(entt::entity a_entity)
+{
+  using traits = entt::entt_traits<std::underlying_type_t<entt::entity>>;
+  return static_cast<uint32_t>(a_entity) & traits::entity_mask;
+}
+
+// an entity recorded for creation, it exists once the buffer is applied
+struct PendingEntity {
+  uint32_t index{};
+};
+
+struct CommandStats {
+  uint32_t commands{};
+  uint32_t applies{};
+  double applyMs{};
+};
+
+// Structural changes to the registry (create, assign, destroy) recorded while systems
+// iterate and applied together at a sync point. Commands go to a lane, each lane is
+// written by one thread at a time and needs no lock. Lanes are applied in index order and
+// each lane in recording order, so the result doesn't depend on thread timing.
+class CommandBuffer {
+public:
+  class Recorder {
+  public:
+    PendingEntity create();
+
+    template<typename Component>
+    void assign(PendingEntity a_entity, Component const& a_component)
+    {
+      m_commands.push_back({ CommandType::Assign, entt::null, a_entity.index, a_component });
+    }
+
+    template<typename Component>
+    void assign(entt::entity a_entity, Component const& a_component)
+    {
+      m_commands.push_back({ CommandType::Assign, a_entity, 0, a_component });
+    }
+
+    void destroy(entt::entity a_entity);
+
+    // recorded for destruction by this lane and not applied yet
+    bool isDestroyed(entt::entity a_entity) const;
+
+    size_t getCommandCount() const { return m_commands.size(); }
+
+  private:
+    friend class CommandBuffer;
+
+    enum class CommandType : uint8_t {
+      Create,
+      Assign,
+      Destroy
+    };
+
+    // Physics also tags the entity with its type
+    using Payload = std::variant<std::monostate, Physics, Model, Texture>;
+
+    struct Command {
+      CommandType type{};
+      // entt::null for entities created by this lane
+      entt::entity entity{ entt::null };
+      uint32_t pending{};
+      Payload payload{};
+    };
+
+    void clear();
+
+    std::vector<Command> m_commands{};
+    uint32_t m_creates{};
+    // by entity key
+    std::vector<bool> m_destroyed{};
+    std::vector<uint32_t> m_destroyedKeys{};
+  };
+
+  // must not be called while lanes are being recorded
+  void setLaneCount(size_t a_lanes);
+  size_t getLaneCount() const { return m_lanes.size(); }
+
+  Recorder& getRecorder(size_t a_lane = 0) { return m_lanes[a_lane]; }
+
+  void apply(entt::registry& a_registry);
+  void clear();
+
+  // counted since the last call
+  CommandStats takeStats();
+
+private:
+  std::vector<Recorder> m_lanes{ 1 };
+  std::vector<entt::entity> m_created{};
+  CommandStats m_stats{};
+};
+
+#endif //COMMAND_BUFFER_H
@@ -0,0 +1,175 @@
+#include "contact_solver.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace {
+
+// 64 colors fit the per-body bitmask, contacts that find none free share the last color
+// which is solved on one thread
+constexpr uint32_t MAX_COLORS = 64;
+constexpr uint32_t SEQUENTIAL_COLOR = MAX_COLORS;
+
+constexpr size_t MIN_BATCH = 64;
+
+// slow separations don't bounce, keeps resting piles from jittering
+constexpr float RESTITUTION_THRESHOLD = 0.5f;
+
+// fraction of the overlap removed per step and the overlap left alone
+constexpr float POSITION_CORRECTION = 0.4f;
+constexpr float PENETRATION_SLOP = 0.01f;
+
+} // namespace
+
+void ContactSolver::solve(Body* a_bodies, size_t a_count, ContactSettings const& a_settings, JobSystem& a_jobs)
+{
+  findContacts(a_bodies, a_count, a_settings.restitution);
+  colorContacts(a_count);
+
+  if (m_colored.empty())
+    return;
+
+  for (uint32_t iteration = 0; iteration < a_settings.iterations; ++iteration) {
+    forEachColor(a_jobs, [&](Contact& a_contact) {
+      auto& a = a_bodies[a_contact.a];
+      auto& b = a_bodies[a_contact.b];
+
+      float const relativeVelocity = glm::dot(b.velocity - a.velocity, a_contact.normal);
+      float const lambda = (a_contact.targetVelocity - relativeVelocity) / (a.inverseMass + b.inverseMass);
+
+      // accumulated impulses may only push apart
+      float const impulse = std::max(a_contact.impulse + lambda, 0.0f);
+      float const delta = impulse - a_contact.impulse;
+      a_contact.impulse = impulse;
+
+      a.velocity -= a_contact.normal * (delta * a.inverseMass);
+      b.velocity += a_contact.normal * (delta * b.inverseMass);
+    });
+  }
+
+  forEachColor(a_jobs, [&](Contact& a_contact) {
+    auto& a = a_bodies[a_contact.a];
+    auto& b = a_bodies[a_contact.b];
+
+    float const correction = std::max(a_contact.penetration - PENETRATION_SLOP, 0.0f) * POSITION_CORRECTION
+      / (a.inverseMass + b.inverseMass);
+
+    a.position -= a_contact.normal * (correction * a.inverseMass);
+    b.position += a_contact.normal * (correction * b.inverseMass);
+  });
+}
+
+void ContactSolver::drawDebug(DebugDraw& a_draw) const
+{
+  m_grid.drawDebug(a_draw, 0.0f, DebugDraw::GREEN);
+
+  for (auto const& contact : m_contacts)
+    a_draw.line(m_positions[contact.a], m_positions[contact.b], DebugDraw::YELLOW);
+}
+
+void ContactSolver::findContacts(Body const* a_bodies, size_t a_count, float a_restitution)
+{
+  m_contacts.clear();
+
+  float maxRadius{};
+  m_positions.resize(a_count);
+  for (size_t i = 0; i < a_count; ++i) {
+    m_positions[i] = a_bodies[i].position;
+    maxRadius = std::max(maxRadius, a_bodies[i].radius);
+  }
+
+  m_grid.build(m_positions.data(), a_count, maxRadius * 2.0f);
+
+  m_grid.forEachPair([&](uint32_t a_first, uint32_t a_second) {
+    // a fixed order per pair keeps the result independent of the grid traversal
+    uint32_t const first = std::min(a_first, a_second);
+    uint32_t const second = std::max(a_first, a_second);
+
+    auto const& a = a_bodies[first];
+    auto const& b = a_bodies[second];
+
+    glm::vec3 const offset = b.position - a.position;
+    float const distanceSquared = glm::dot(offset, offset);
+    float const radii = a.radius + b.radius;
+
+    if (distanceSquared >= radii * radii || a.inverseMass + b.inverseMass <= 0.0f)
+      return;
+
+    float const distance = std::sqrt(distanceSquared);
+
+    Contact contact{};
+    contact.a = first;
+    contact.b = second;
+    // concentric spheres have no normal, pick one so they still separate
+    contact.normal = distance > 0.0f ? offset / distance : glm::vec3(1.0f, 0.0f, 0.0f);
+    contact.penetration = radii - distance;
+
+    float const relativeVelocity = glm::dot(b.velocity - a.velocity, contact.normal);
+    if (relativeVelocity < -RESTITUTION_THRESHOLD)
+      contact.targetVelocity = -a_restitution * relativeVelocity;
+
+    m_contacts.push_back(contact);
+  });
+}
+
+void ContactSolver::colorContacts(size_t a_count)
+{
+  m_bodyColors.assign(a_count, 0);
+  m_contactColors.resize(m_contacts.size());
+
+  std::array<uint32_t, MAX_COLORS + 2> counts{};
+
+  for (size_t i = 0; i < m_contacts.size(); ++i) {
+    auto const& contact = m_contacts[i];
+    uint64_t const used = m_bodyColors[contact.a] | m_bodyColors[contact.b];
+
+    uint32_t color{ SEQUENTIAL_COLOR };
+    if (~used != 0) {
+      color = 0;
+      while (used & (uint64_t{ 1 } << color))
+        ++color;
+
+      m_bodyColors[contact.a] |= uint64_t{ 1 } << color;
+      m_bodyColors[contact.b] |= uint64_t{ 1 } << color;
+    }
+
+    m_contactColors[i] = static_cast<uint8_t>(color);
+    ++counts[color + 1];
+  }
+
+  // counting sort, contacts keep their discovery order within a color
+  uint32_t colors{};
+  for (uint32_t color = 0; color <= MAX_COLORS; ++color) {
+    if (counts[color + 1] > 0)
+      colors = color + 1;
+    counts[color + 1] += counts[color];
+  }
+
+  m_colorStarts.assign(counts.begin(), counts.begin() + colors + 1);
+
+  m_colored.resize(m_contacts.size());
+  for (size_t i = 0; i < m_contacts.size(); ++i)
+    m_colored[counts[m_contactColors[i]]++] = m_contacts[i];
+}
+
+template<class Function>
+void ContactSolver::forEachColor(JobSystem& a_jobs, Function const& a_function)
+{
+  for (size_t color = 0; color + 1 < m_colorStarts.size(); ++color) {
+    size_t const begin = m_colorStarts[color];
+    size_t const end = m_colorStarts[color + 1];
+
+    auto const solveRange = [&](size_t a_begin, size_t a_end) {
+      for (size_t i = begin + a_begin; i < begin + a_end; ++i)
+        a_function(m_colored[i]);
+    };
+
+    if (color == SEQUENTIAL_COLOR)
+      solveRange(0, end - begin);
+    else
+      a_jobs.parallelFor(end - begin, MIN_BATCH, solveRange);
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef CONTACT_SOLVER_H
+#define CONTACT_SOLVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "debug_draw.h"
+#include "job_system.h"
+#include "spatial_grid.h"
+
+struct ContactSettings {
+  bool enabled{};
+  float restitution{ 0.5f };
+  // mass = density * sphere volume of the collision radius
+  float density{ 1.0f };
+  uint32_t iterations{ 4 };
+};
+
+// Sphere contacts between rigid bodies. Pairs come from a SpatialGrid, and contacts are
+// graph colored so no two contacts of a color share a body. Every color is then solved
+// in parallel without locks, and the result doesn't depend on the number of threads.
+class ContactSolver {
+public:
+  struct Body {
+    glm::vec3 position{};
+    glm::vec3 velocity{};
+    float radius{};
+    float inverseMass{};
+  };
+
+  void solve(Body* a_bodies, size_t a_count, ContactSettings const& a_settings, JobSystem& a_jobs);
+
+  size_t getContactCount() const { return m_contacts.size(); }
+  size_t getColorCount() const { return m_colorStarts.empty() ? 0 : m_colorStarts.size() - 1; }
+
+  // the contacts of the last solve between the positions they were found at
+  void drawDebug(DebugDraw& a_draw) const;
+
+private:
+  struct Contact {
+    uint32_t a{};
+    uint32_t b{};
+    glm::vec3 normal{};
+    float penetration{};
+    float targetVelocity{};
+    float impulse{};
+  };
+
+  void findContacts(Body const* a_bodies, size_t a_count, float a_restitution);
+  void colorContacts(size_t a_count);
+
+  template<class Function>
+  void forEachColor(JobSystem& a_jobs, Function const& a_function);
+
+  SpatialGrid m_grid{};
+  std::vector<glm::vec3> m_positions{};
+  std::vector<Contact> m_contacts{};
+  std::vector<Contact> m_colored{};
+  std::vector<uint64_t> m_bodyColors{};
+  std::vector<uint8_t> m_contactColors{};
+  // contacts of color c are m_colored[m_colorStarts[c], m_colorStarts[c + 1])
+  std::vector<uint32_t> m_colorStarts{};
+};
+
+#endif //CONTACT_SOLVER_H
@@ -2,6 +2,9 @@
 #define DATA_TYPES_H
 
 #include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
@@ -46,8 +49,6 @@ struct Camera {
 };
 
 struct Physics {
-  glm::mat4 modelMatrix{};
-  glm::mat4 debugBoxMatrix{};
   glm::vec3 position{};
   glm::vec3 velocity{};
   glm::vec3 acceleration{};
@@ -57,6 +58,20 @@ struct Physics {
   EntityType entityType{};
 };
 
+struct AsteroidSpawn {
+  EntityType type{};
+  glm::vec3 position{};
+  glm::vec3 rotationAxis{};
+  float rotationVelocity{};
+};
+
+// queued by checkCollision and created in one batch after the collision pass
+struct FragmentSpawn {
+  EntityType type{};
+  glm::vec3 position{};
+  glm::vec3 velocity{};
+};
+
 enum class Key {
   Left,
   Right,
@@ -78,6 +93,46 @@ struct Settings {
   float spaceshipMass{};
   float asteroidsAppearanceFrequency{};
   float asteroidsApperanceIncrease{};
+  uint64_t seed{};
+  bool pipelinedSimulation{};
+  bool hitscan{};
+};
+
+// what is left of a hitscan shot, drawn where it ended for a moment
+struct Tracer {
+  glm::vec3 position{};
+  float remaining{};
+};
+
+struct RenderItem {
+  uint32_t vao{};
+  uint32_t vertices{};
+  uint32_t texture{};
+  glm::mat4 modelMatrix{};
+};
+
+// see DebugDraw, the color is RGBA with red in the lowest byte
+struct DebugVertex {
+  glm::vec3 position{};
+  uint32_t color{};
+};
+
+// everything drawing needs, built from the registry at the end of a simulation step
+struct RenderSnapshot {
+  std::vector<RenderItem> items{};
+  glm::mat4 view{};
+  uint32_t candidates{};
+  std::vector<DebugVertex> debugLines{};
+};
+
+// command line, see main.cc
+struct Options {
+  std::optional<uint64_t> seed{};
+  std::string recordPath{};
+  std::string replayPath{};
+  std::string capacityPath{};
+  uint32_t ticks{};
+  bool headless{};
 };
 
 #endif //DATA_TYPES_H
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "debug_draw.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <glad/glad.h>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "log.h"
+#include "memory_tracker.h"
+#include "utils.h"
+
+namespace {
+
+const char* const VERTEX_SHADER_PATH = "data/shaders/debug_line.vert";
+const char* const FRAGMENT_SHADER_PATH = "data/shaders/debug_line.frag";
+
+const int POSITION_LOCATION = 0;
+const int COLOR_LOCATION = 1;
+
+constexpr size_t SPHERE_SEGMENTS = 16;
+constexpr size_t MIN_CAPACITY = 64 * 1024;
+
+} // namespace
+
+void DebugDraw::box(glm::vec3 const& a_min, glm::vec3 const& a_max, uint32_t a_color)
+{
+  if (!m_enabled)
+    return;
+
+  glm::vec3 const corners[8]{
+    { a_min.x, a_min.y, a_min.z }, { a_max.x, a_min.y, a_min.z },
+    { a_max.x, a_max.y, a_min.z }, { a_min.x, a_max.y, a_min.z },
+    { a_min.x, a_min.y, a_max.z }, { a_max.x, a_min.y, a_max.z },
+    { a_max.x, a_max.y, a_max.z }, { a_min.x, a_max.y, a_max.z },
+  };
+
+  for (int i = 0; i < 4; ++i) {
+    line(corners[i], corners[(i + 1) % 4], a_color);
+    line(corners[i + 4], corners[(i + 1) % 4 + 4], a_color);
+    line(corners[i], corners[i + 4], a_color);
+  }
+}
+
+void DebugDraw::sphere(glm::vec3 const& a_center, float a_radius, uint32_t a_color)
+{
+  if (!m_enabled)
+    return;
+
+  float const step = glm::two_pi<float>() / SPHERE_SEGMENTS;
+
+  for (size_t i = 0; i < SPHERE_SEGMENTS; ++i) {
+    float const c0 = std::cos(step * i) * a_radius;
+    float const s0 = std::sin(step * i) * a_radius;
+    float const c1 = std::cos(step * (i + 1)) * a_radius;
+    float const s1 = std::sin(step * (i + 1)) * a_radius;
+
+    line(a_center + glm::vec3(c0, s0, 0.0f), a_center + glm::vec3(c1, s1, 0.0f), a_color);
+    line(a_center + glm::vec3(c0, 0.0f, s0), a_center + glm::vec3(c1, 0.0f, s1), a_color);
+    line(a_center + glm::vec3(0.0f, c0, s0), a_center + glm::vec3(0.0f, c1, s1), a_color);
+  }
+}
+
+void DebugDraw::gridCell(int32_t a_x, int32_t a_z, float a_cellSize, float a_y, uint32_t a_color)
+{
+  if (!m_enabled)
+    return;
+
+  float const x0 = a_x * a_cellSize;
+  float const z0 = a_z * a_cellSize;
+  float const x1 = x0 + a_cellSize;
+  float const z1 = z0 + a_cellSize;
+
+  line({ x0, a_y, z0 }, { x1, a_y, z0 }, a_color);
+  line({ x1, a_y, z0 }, { x1, a_y, z1 }, a_color);
+  line({ x1, a_y, z1 }, { x0, a_y, z1 }, a_color);
+  line({ x0, a_y, z1 }, { x0, a_y, z0 }, a_color);
+}
+
+void DebugDraw::swap(std::vector<DebugVertex>& a_vertices)
+{
+  m_vertices.swap(a_vertices);
+  m_vertices.clear();
+}
+
+bool DebugLineRenderer::setup()
+{
+  if (!loadShader())
+    return false;
+
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_vbo);
+
+  glBindVertexArray(m_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+  glVertexAttribPointer(POSITION_LOCATION, 3, GL_FLOAT, GL_FALSE, sizeof(DebugVertex),
+    (void*)offsetof(DebugVertex, position));
+  glEnableVertexAttribArray(POSITION_LOCATION);
+
+  glVertexAttribPointer(COLOR_LOCATION, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(DebugVertex),
+    (void*)offsetof(DebugVertex, color));
+  glEnableVertexAttribArray(COLOR_LOCATION);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+  return true;
+}
+
+bool DebugLineRenderer::loadShader()
+{
+  Shader shader{};
+  if (!Utils::load_program(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, shader)) {
+    Log::render().warn("debug line shader not loaded");
+    return false;
+  }
+
+  if (m_shader.program)
+    glDeleteProgram(m_shader.program);
+
+  m_shader = shader;
+  return true;
+}
+
+// leaves its own program bound, the caller restores the one it draws with
+void DebugLineRenderer::draw(std::vector<DebugVertex> const& a_vertices, glm::mat4 const& a_viewProjection)
+{
+  if (a_vertices.empty() || !m_vao)
+    return;
+
+  size_t const bytes = a_vertices.size() * sizeof(DebugVertex);
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+
+  // orphaned every frame so the driver never waits for last frame's draw, grown by doubling
+  if (bytes > m_capacity) {
+    m_capacity = std::max(m_capacity * 2, std::max(bytes, MIN_CAPACITY));
+    Memory::track_gl_buffer(m_vbo, m_capacity);
+  }
+
+  glBufferData(GL_ARRAY_BUFFER, m_capacity, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, a_vertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glUseProgram(m_shader.program);
+  int const location{ glGetUniformLocation(m_shader.program, "viewProjection") };
+  glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(a_viewProjection));
+
+  glBindVertexArray(m_vao);
+  glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(a_vertices.size()));
+  glBindVertexArray(0);
+}
@@ -0,0 +1,70 @@
+#ifndef DEBUG_DRAW_H
+#define DEBUG_DRAW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "data_types.h"
+
+// Immediate mode debug geometry. Everything is recorded as line vertices during the
+// simulation step and drawn in one batch by DebugLineRenderer. Disabled, every call
+// returns on its first line; callers that loop to build their geometry check isEnabled.
+class DebugDraw {
+public:
+  // 0xAABBGGRR, the byte order the vertex attribute reads
+  static constexpr uint32_t WHITE = 0xffffffff;
+  static constexpr uint32_t RED = 0xff3030ff;
+  static constexpr uint32_t GREEN = 0xff30ff30;
+  static constexpr uint32_t BLUE = 0xffff8030;
+  static constexpr uint32_t YELLOW = 0xff30ffff;
+
+  void setEnabled(bool a_enabled) { m_enabled = a_enabled; }
+  bool isEnabled() const { return m_enabled; }
+
+  void line(glm::vec3 const& a_from, glm::vec3 const& a_to, uint32_t a_color)
+  {
+    if (!m_enabled)
+      return;
+
+    m_vertices.push_back({ a_from, a_color });
+    m_vertices.push_back({ a_to, a_color });
+  }
+
+  void ray(glm::vec3 const& a_origin, glm::vec3 const& a_direction, float a_length, uint32_t a_color)
+  {
+    line(a_origin, a_origin + a_direction * a_length, a_color);
+  }
+
+  void box(glm::vec3 const& a_min, glm::vec3 const& a_max, uint32_t a_color);
+  // three great circles
+  void sphere(glm::vec3 const& a_center, float a_radius, uint32_t a_color);
+  // a cell of a grid over the XZ plane, outlined at a_y
+  void gridCell(int32_t a_x, int32_t a_z, float a_cellSize, float a_y, uint32_t a_color);
+
+  // hands the recorded vertices over, a_vertices gets the storage to record into next
+  void swap(std::vector<DebugVertex>& a_vertices);
+  void clear() { m_vertices.clear(); }
+
+private:
+  std::vector<DebugVertex> m_vertices{};
+  bool m_enabled{};
+};
+
+// One dynamic vertex buffer, refilled every frame and drawn with a single glDrawArrays(GL_LINES).
+class DebugLineRenderer {
+public:
+  bool setup();
+  bool loadShader();
+  void draw(std::vector<DebugVertex> const& a_vertices, glm::mat4 const& a_viewProjection);
+
+private:
+  Shader m_shader{};
+  uint32_t m_vao{};
+  uint32_t m_vbo{};
+  size_t m_capacity{};
+};
+
+#endif //DEBUG_DRAW_H
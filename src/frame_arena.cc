@@ -0,0 +1,79 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "log.h"
+
+namespace {
+
+size_t align_up(size_t a_value, size_t a_alignment)
+{
+  return (a_value + a_alignment - 1) & ~(a_alignment - 1);
+}
+
+} // namespace
+
+FrameArena::FrameArena(size_t a_capacity)
+  : m_buffer{ std::make_unique<std::byte[]>(a_capacity) }
+  , m_capacity{ a_capacity }
+{
+}
+
+void FrameArena::reset()
+{
+  if (m_highWater > m_capacity) {
+    Log::game().info("frame arena grows from {} to {} KiB", m_capacity / 1024, m_highWater / 1024);
+
+    m_capacity = align_up(m_highWater, alignof(std::max_align_t));
+    m_buffer = std::make_unique<std::byte[]>(m_capacity);
+  }
+
+  m_overflow.release();
+  m_offset = 0;
+  m_overflowBytes = 0;
+  m_used = 0;
+}
+
+void* FrameArena::do_allocate(size_t a_bytes, size_t a_alignment)
+{
+  size_t const offset = align_up(reinterpret_cast<uintptr_t>(m_buffer.get()) + m_offset, a_alignment)
+    - reinterpret_cast<uintptr_t>(m_buffer.get());
+
+  void* pointer{};
+
+  if (offset + a_bytes > m_capacity) {
+    // where it lands in the grown arena isn't known yet, count the worst case padding
+    m_overflowBytes += a_bytes + a_alignment - 1;
+    pointer = m_overflow.allocate(a_bytes, a_alignment);
+  } else {
+    m_offset = offset + a_bytes;
+    pointer = m_buffer.get() + offset;
+  }
+
+  // padding included, so the grown arena really fits the whole frame
+  m_used = m_offset + m_overflowBytes;
+  m_highWater = std::max(m_highWater, m_used);
+
+  return pointer;
+}
+
+void FrameArena::do_deallocate(void* a_pointer, size_t a_bytes, size_t a_alignment)
+{
+}
+
+bool FrameArena::do_is_equal(std::pmr::memory_resource const& a_other) const noexcept
+{
+  return this == &a_other;
+}
+
+FrameAllocator::FrameAllocator(size_t a_capacity)
+  : m_arenas{ FrameArena{ a_capacity }, FrameArena{ a_capacity } }
+{
+}
+
+void FrameAllocator::beginFrame()
+{
+  m_current ^= 1;
+  m_arenas[m_current].reset();
+}
@@ -0,0 +1,57 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that only lives for a frame. Deallocation is a no-op, the
+// whole arena is released at once by reset(). Allocations past the capacity go to the
+// heap and the arena grows to the high-water mark on the next reset, so a steady
+// workload settles on zero heap allocations per frame.
+class FrameArena : public std::pmr::memory_resource {
+public:
+  explicit FrameArena(size_t a_capacity);
+
+  void reset();
+
+  size_t getUsed() const { return m_used; }
+  size_t getCapacity() const { return m_capacity; }
+  size_t getHighWater() const { return m_highWater; }
+
+private:
+  void* do_allocate(size_t a_bytes, size_t a_alignment) override;
+  void do_deallocate(void* a_pointer, size_t a_bytes, size_t a_alignment) override;
+  bool do_is_equal(std::pmr::memory_resource const& a_other) const noexcept override;
+
+  std::unique_ptr<std::byte[]> m_buffer{};
+  size_t m_capacity{};
+  size_t m_offset{};
+  size_t m_overflowBytes{};
+  size_t m_used{};
+  size_t m_highWater{};
+  std::pmr::monotonic_buffer_resource m_overflow{ std::pmr::new_delete_resource() };
+};
+
+// Two arenas used alternately, so whatever is allocated during a frame stays valid
+// through the following one.
+class FrameAllocator {
+public:
+  explicit FrameAllocator(size_t a_capacity);
+
+  void beginFrame();
+
+  FrameArena& current() { return m_arenas[m_current]; }
+
+private:
+  std::array<FrameArena, 2> m_arenas;
+  size_t m_current{};
+};
+
+// transient containers allocate from a frame arena, e.g. FrameVector<int> v{ &arena };
+template<class T>
+using FrameVector = std::pmr::vector<T>;
+
+#endif //FRAME_ARENA_H
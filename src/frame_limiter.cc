@@ -0,0 +1,55 @@
+#include "frame_limiter.h"
+
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <timeapi.h>
+#endif
+
+FrameLimiter::FrameLimiter()
+{
+#ifdef _WIN32
+  // the default scheduler tick of ~15.6 ms makes short sleeps useless
+  timeBeginPeriod(1);
+#endif
+}
+
+FrameLimiter::~FrameLimiter()
+{
+#ifdef _WIN32
+  timeEndPeriod(1);
+#endif
+}
+
+void FrameLimiter::setTarget(float a_fps, float a_spinMs)
+{
+  using seconds = std::chrono::duration<double>;
+  using milliseconds = std::chrono::duration<double, std::milli>;
+
+  m_period = a_fps > 0.0f ? std::chrono::duration_cast<Clock::duration>(seconds(1.0 / a_fps)) : Clock::duration{};
+  m_spin = std::chrono::duration_cast<Clock::duration>(milliseconds(a_spinMs > 0.0f ? a_spinMs : 0.0f));
+  m_next = Clock::now() + m_period;
+}
+
+void FrameLimiter::wait()
+{
+  if (m_period == Clock::duration{})
+    return;
+
+  auto now = Clock::now();
+
+  // more than a frame behind, start over instead of rushing to catch up
+  if (now - m_next > m_period) {
+    m_next = now + m_period;
+    return;
+  }
+
+  if (m_next - now > m_spin)
+    std::this_thread::sleep_for(m_next - now - m_spin);
+
+  while (Clock::now() < m_next)
+    std::this_thread::yield();
+
+  m_next += m_period;
+}
@@ -0,0 +1,38 @@
+#ifndef FRAME_LIMITER_H
+#define FRAME_LIMITER_H
+
+#include <chrono>
+
+struct FramePacingSettings {
+  // 0 off, 1 vsync, -1 adaptive vsync (late frames tear instead of waiting a whole refresh)
+  int swapInterval{ 1 };
+  // 0 leaves the frame rate to the swap interval
+  float targetFps{};
+  // the last part of the wait is spent spinning, sleep wakes up too late for that
+  float spinMs{ 1.0f };
+};
+
+// Caps the frame rate on the CPU side. Sleeps for most of the remaining frame time and
+// spins the rest, so frames start on time without burning a core for the whole frame.
+class FrameLimiter {
+public:
+  FrameLimiter();
+  ~FrameLimiter();
+
+  FrameLimiter(FrameLimiter const&) = delete;
+  FrameLimiter& operator=(FrameLimiter const&) = delete;
+
+  void setTarget(float a_fps, float a_spinMs);
+
+  // blocks until the next frame is due, call once per frame after presenting
+  void wait();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::duration m_period{};
+  Clock::duration m_spin{};
+  Clock::time_point m_next{};
+};
+
+#endif //FRAME_LIMITER_H
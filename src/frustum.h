@@ -0,0 +1,40 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <array>
+#include <glm/glm.hpp>
+
+// The six clip planes of a view-projection matrix, normalized and facing inwards.
+class Frustum {
+public:
+  explicit Frustum(glm::mat4 const& a_viewProjection)
+  {
+    glm::mat4 const rows{ glm::transpose(a_viewProjection) };
+
+    m_planes[0] = rows[3] + rows[0];
+    m_planes[1] = rows[3] - rows[0];
+    m_planes[2] = rows[3] + rows[1];
+    m_planes[3] = rows[3] - rows[1];
+    m_planes[4] = rows[3] + rows[2];
+    m_planes[5] = rows[3] - rows[2];
+
+    for (auto& plane : m_planes)
+      plane /= glm::length(glm::vec3(plane));
+  }
+
+  // conservative, spheres near a corner may pass without touching the frustum
+  bool intersectsSphere(glm::vec3 const& a_center, float a_radius) const
+  {
+    for (auto const& plane : m_planes) {
+      if (glm::dot(glm::vec3(plane), a_center) + plane.w < -a_radius)
+        return false;
+    }
+
+    return true;
+  }
+
+private:
+  std::array<glm::vec4, 6> m_planes{};
+};
+
+#endif //FRUSTUM_H
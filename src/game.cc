@@ -2,12 +2,16 @@
 
 #include <GL/GL.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <fstream>
 #include <vector>
-#include <iostream>
 #include <math.h>
 #include <chrono>
 #include <cassert>
@@ -17,102 +21,159 @@
 #include <imgui_impl_sdl.h>
 #include <imgui_impl_opengl3.h>
 
+#include "collision.h"
+#include "log.h"
+#include "memory_tracker.h"
 #include "utils.h"
 
-std::random_device g_rd;
-std::mt19937 g_gen{ g_rd() };
-std::uniform_real_distribution<float> g_asteroidAngleVelocity(10.05f, 30.5f);
-
-std::vector<float> g_vertices = {
-  -1.0f, -1.0f, -1.0f,  0.0f, 0.0f,
-   1.0f, -1.0f, -1.0f,  1.0f, 0.0f,
-   1.0f,  1.0f, -1.0f,  1.0f, 1.0f,
-   1.0f,  1.0f, -1.0f,  1.0f, 1.0f,
-  -1.0f,  1.0f, -1.0f,  0.0f, 1.0f,
-  -1.0f, -1.0f, -1.0f,  0.0f, 0.0f,
-
-  -1.0f, -1.0f,  1.0f,  0.0f, 0.0f,
-   1.0f, -1.0f,  1.0f,  1.0f, 0.0f,
-   1.0f,  1.0f,  1.0f,  1.0f, 1.0f,
-   1.0f,  1.0f,  1.0f,  1.0f, 1.0f,
-  -1.0f,  1.0f,  1.0f,  0.0f, 1.0f,
-  -1.0f, -1.0f,  1.0f,  0.0f, 0.0f,
-
-  -1.0f,  1.0f,  1.0f,  1.0f, 0.0f,
-  -1.0f,  1.0f, -1.0f,  1.0f, 1.0f,
-  -1.0f, -1.0f, -1.0f,  0.0f, 1.0f,
-  -1.0f, -1.0f, -1.0f,  0.0f, 1.0f,
-  -1.0f, -1.0f,  1.0f,  0.0f, 0.0f,
-  -1.0f,  1.0f,  1.0f,  1.0f, 0.0f,
-
-   1.0f,  1.0f,  1.0f,  1.0f, 0.0f,
-   1.0f,  1.0f, -1.0f,  1.0f, 1.0f,
-   1.0f, -1.0f, -1.0f,  0.0f, 1.0f,
-   1.0f, -1.0f, -1.0f,  0.0f, 1.0f,
-   1.0f, -1.0f,  1.0f,  0.0f, 0.0f,
-   1.0f,  1.0f,  1.0f,  1.0f, 0.0f,
-
-  -1.0f, -1.0f, -1.0f,  0.0f, 1.0f,
-   1.0f, -1.0f, -1.0f,  1.0f, 1.0f,
-   1.0f, -1.0f,  1.0f,  1.0f, 0.0f,
-   1.0f, -1.0f,  1.0f,  1.0f, 0.0f,
-  -1.0f, -1.0f,  1.0f,  0.0f, 0.0f,
-  -1.0f, -1.0f, -1.0f,  0.0f, 1.0f,
-
-  -1.0f,  1.0f, -1.0f,  0.0f, 1.0f,
-   1.0f,  1.0f, -1.0f,  1.0f, 1.0f,
-   1.0f,  1.0f,  1.0f,  1.0f, 0.0f,
-   1.0f,  1.0f,  1.0f,  1.0f, 0.0f,
-  -1.0f,  1.0f,  1.0f,  0.0f, 0.0f,
-  -1.0f,  1.0f, -1.0f,  0.0f, 1.0f
+constexpr double COLLISION_LOG_INTERVAL = 1.0;
+
+// per arena, grows to the high-water mark if a frame needs more
+constexpr size_t FRAME_ARENA_SIZE = 256 * 1024;
+
+constexpr int64_t MIB = 1024 * 1024;
+
+// 1 ms each, the last one collects everything slower
+constexpr size_t FRAME_HISTOGRAM_BUCKETS = 40;
+
+// deterministic runs step the simulation at a fixed rate so replays line up tick by tick
+constexpr float FIXED_TICK = 1.0f / 60.0f;
+constexpr double MAX_FRAME_TIME = 0.25;
+
+constexpr float FRAGMENT_SPEED_MIN = 2.0f;
+constexpr float FRAGMENT_SPEED_MAX = 6.0f;
+
+// hitscan shots reach a bit beyond the activation line of the corridor
+constexpr float HITSCAN_RANGE = 80.0f;
+constexpr float TRACER_LIFETIME = 0.1f;
+
+// a stalled frame must not fire seconds worth of hitscan shots at once
+constexpr uint32_t MAX_SHOTS_PER_TICK = 64;
+
+constexpr float MIN_SHOOTING_FREQUENCY = 0.1f;
+constexpr float MAX_SHOOTING_FREQUENCY = 1000.0f;
+
+// entity pools are sized for a busy field once per game instead of growing during play
+constexpr size_t ENTITY_RESERVE = 4096;
+
+// the Entities window rebuilds its rows continuously, this many entities or row moves per frame
+constexpr size_t INSPECTOR_SCAN_SLICE = 4096;
+constexpr size_t INSPECTOR_SORT_BUDGET = 16384;
+constexpr float INSPECTOR_DETAILS_HEIGHT = 150.0f;
+
+const char* const VERTEX_SHADER_PATH = "data/shaders/shader.vert";
+const char* const FRAGMENT_SHADER_PATH = "data/shaders/shader.frag";
+const char* const CONFIG_PATH = "data/configs/config.json";
+const char* const MEMORY_CSV_PATH = "memory.csv";
+
+namespace {
+
+struct ComponentStorage {
+  std::string_view name{};
+  size_t size{};
+  size_t capacity{};
+  size_t bytes{};
 };
 
+// dense arrays only, the sparse sets add roughly one entity index per possible entity
+template<class Component>
+ComponentStorage get_component_storage(entt::registry const& a_registry, std::string_view a_name)
+{
+  ComponentStorage storage{};
+  storage.name = a_name;
+  storage.size = a_registry.size<Component>();
+  storage.capacity = a_registry.capacity<Component>();
+  storage.bytes = storage.capacity * (sizeof(Component) + sizeof(entt::entity));
+  return storage;
+}
+
+std::array<ComponentStorage, 3> get_registry_storage(entt::registry const& a_registry)
+{
+  return {
+    get_component_storage<Physics>(a_registry, "Physics"),
+    get_component_storage<Model>(a_registry, "Model"),
+    get_component_storage<Texture>(a_registry, "Texture")
+  };
+}
+
+} // namespace
+
 //void APIENTRY myGlDebugOutput(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
 void APIENTRY myGlDebugOutput(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
 {
   // ignore non-significant error/warning codes
   if(id == 131169 || id == 131185 || id == 131218 || id == 131204) return; 
 
-  std::cout << "---------------" << std::endl;
-  std::cout << "Debug message (" << id << "): " <<  message << std::endl;
-
+  std::string_view sourceName{};
   switch (source)
   {
-  case GL_DEBUG_SOURCE_API:             std::cout << "Source: API"; break;
-  case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   std::cout << "Source: Window System"; break;
-  case GL_DEBUG_SOURCE_SHADER_COMPILER: std::cout << "Source: Shader Compiler"; break;
-  case GL_DEBUG_SOURCE_THIRD_PARTY:     std::cout << "Source: Third Party"; break;
-  case GL_DEBUG_SOURCE_APPLICATION:     std::cout << "Source: Application"; break;
-  case GL_DEBUG_SOURCE_OTHER:           std::cout << "Source: Other"; break;
+  case GL_DEBUG_SOURCE_API:             sourceName = "API"; break;
+  case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   sourceName = "Window System"; break;
+  case GL_DEBUG_SOURCE_SHADER_COMPILER: sourceName = "Shader Compiler"; break;
+  case GL_DEBUG_SOURCE_THIRD_PARTY:     sourceName = "Third Party"; break;
+  case GL_DEBUG_SOURCE_APPLICATION:     sourceName = "Application"; break;
+  case GL_DEBUG_SOURCE_OTHER:           sourceName = "Other"; break;
   }
-  std::cout << std::endl;
 
+  std::string_view typeName{};
   switch (type)
   {
-  case GL_DEBUG_TYPE_ERROR:               std::cout << "Type: Error"; break;
-  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: std::cout << "Type: Deprecated Behaviour"; break;
-  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  std::cout << "Type: Undefined Behaviour"; break; 
-  case GL_DEBUG_TYPE_PORTABILITY:         std::cout << "Type: Portability"; break;
-  case GL_DEBUG_TYPE_PERFORMANCE:         std::cout << "Type: Performance"; break;
-  case GL_DEBUG_TYPE_MARKER:              std::cout << "Type: Marker"; break;
-  case GL_DEBUG_TYPE_PUSH_GROUP:          std::cout << "Type: Push Group"; break;
-  case GL_DEBUG_TYPE_POP_GROUP:           std::cout << "Type: Pop Group"; break;
-  case GL_DEBUG_TYPE_OTHER:               std::cout << "Type: Other"; break;
-  }
-  std::cout << std::endl;
+  case GL_DEBUG_TYPE_ERROR:               typeName = "Error"; break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: typeName = "Deprecated Behaviour"; break;
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  typeName = "Undefined Behaviour"; break; 
+  case GL_DEBUG_TYPE_PORTABILITY:         typeName = "Portability"; break;
+  case GL_DEBUG_TYPE_PERFORMANCE:         typeName = "Performance"; break;
+  case GL_DEBUG_TYPE_MARKER:              typeName = "Marker"; break;
+  case GL_DEBUG_TYPE_PUSH_GROUP:          typeName = "Push Group"; break;
+  case GL_DEBUG_TYPE_POP_GROUP:           typeName = "Pop Group"; break;
+  case GL_DEBUG_TYPE_OTHER:               typeName = "Other"; break;
+  }
 
+  auto level{ spdlog::level::info };
   switch (severity)
   {
-  case GL_DEBUG_SEVERITY_HIGH:         std::cout << "Severity: high"; break;
-  case GL_DEBUG_SEVERITY_MEDIUM:       std::cout << "Severity: medium"; break;
-  case GL_DEBUG_SEVERITY_LOW:          std::cout << "Severity: low"; break;
-  case GL_DEBUG_SEVERITY_NOTIFICATION: std::cout << "Severity: notification"; break;
+  case GL_DEBUG_SEVERITY_HIGH:         level = spdlog::level::err; break;
+  case GL_DEBUG_SEVERITY_MEDIUM:       level = spdlog::level::warn; break;
+  case GL_DEBUG_SEVERITY_LOW:          level = spdlog::level::info; break;
+  case GL_DEBUG_SEVERITY_NOTIFICATION: level = spdlog::level::debug; break;
   }
-  std::cout << std::endl;
+
+  Log::render().log(level, "Debug message ({}): {} [source: {}, type: {}]", id, message, sourceName, typeName);
+  Log::render().flush();
   assert(false);
 }
 
-Game::Game()
+Game::Game(Options const& a_options)
+  : m_options{ a_options }
+  , m_frameAllocator{ FRAME_ARENA_SIZE }
+{
+  if (!m_options.headless) {
+    setupWindow();
+    loadAssets();
+  } else {
+    loadCollisionShapes();
+  }
+
+  loadSettings();
+  setupCamera();
+  setupRandom();
+
+  if (!m_options.capacityPath.empty())
+    m_capacityProbe = std::make_unique<CapacityProbe>(m_capacitySettings, m_options.headless);
+
+  if (!m_options.headless) {
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS); 
+    glDebugMessageCallback(myGlDebugOutput, nullptr);
+    glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+
+    applyFramePacing();
+
+    m_assetWatcher.start({ "data/shaders", "data/models", "data/textures", "data/configs" });
+  }
+}
+
+void Game::setupWindow()
 {
   SDL_Init(SDL_INIT_EVERYTHING);
 
@@ -143,6 +204,7 @@ Game::Game()
   gladLoadGLLoader(SDL_GL_GetProcAddress);
 
   IMGUI_CHECKVERSION();
+  ImGui::SetAllocatorFunctions(Memory::imgui_allocate, Memory::imgui_free);
   ImGui::CreateContext();
   ImGui::StyleColorsDark();
 
@@ -150,31 +212,111 @@ Game::Game()
   ImGui_ImplOpenGL3_Init("#version 150");
 
   glViewport(0, 0, 1280, 720);
+}
+
+void Game::loadAssets()
+{
+  Memory::TagScope scope{ Memory::Category::Assets };
+
+  using clock_t = std::chrono::high_resolution_clock;
+  using duration = std::chrono::duration<double, std::milli>;
+  auto const shaderStart = clock_t::now();
 
-  m_shader.program = glCreateProgram();
+  bool const shaderLoaded = Utils::load_program(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, m_shader);
+  assert(shaderLoaded);
 
-  Utils::load_shader("data/shaders/shader.vert", ShaderType::Vertex, m_shader);
-  Utils::load_shader("data/shaders/shader.frag", ShaderType::Fragment, m_shader);
+  const duration shaderTime = clock_t::now() - shaderStart;
+  Log::render().info("Shader setup: {:.2f} ms", shaderTime.count());
 
   m_asteroidsTexture = Utils::load_texture("data/textures/asteroid.png");
   m_playerTexture = Utils::load_texture("data/textures/player.png");
   m_laserTexture = Utils::load_texture("data/textures/laser_beam.png");
 
-  m_models[static_cast<size_t>(EntityType::AsteroidFragment)] = Utils::load_model("data/models/asteroid_fragment.obj");
-  m_models[static_cast<size_t>(EntityType::AsteroidSmall)] = Utils::load_model("data/models/asteroid_small.obj");
-  m_models[static_cast<size_t>(EntityType::AsteroidMedium)] = Utils::load_model("data/models/asteroid_medium.obj");
-  m_models[static_cast<size_t>(EntityType::AsteroidBig)] = Utils::load_model("data/models/asteroid_big.obj");
-  m_models[static_cast<size_t>(EntityType::LaserBeam)] = Utils::load_model("data/models/laser_beam.obj");
-  m_models[static_cast<size_t>(EntityType::Player)] = Utils::load_model("data/models/player.obj");
-  m_models[static_cast<size_t>(EntityType::Box)] = Utils::load_model(g_vertices);
+  // each mesh is parsed once for both the GPU model and the collision shape
+  for (size_t i = 0; i < ARCHETYPE_TRAITS.size(); ++i) {
+    auto const path = ARCHETYPE_TRAITS[i].modelPath;
+    if (path.empty())
+      continue;
 
-  loadSettings();
-  setupCamera();
+    if (auto vertices = Utils::read_model(path)) {
+      m_models[i] = Utils::load_model(*vertices);
+      buildCollisionShape(i, *vertices);
+    }
+  }
+
+  m_debugLineRenderer.setup();
+}
+
+// headless runs have no GPU models, the shapes are read on their own there
+void Game::loadCollisionShapes()
+{
+  Memory::TagScope scope{ Memory::Category::Assets };
+
+  for (size_t i = 0; i < ARCHETYPE_TRAITS.size(); ++i) {
+    auto const path = ARCHETYPE_TRAITS[i].modelPath;
+    if (path.empty())
+      continue;
+
+    if (auto vertices = Utils::read_model(path))
+      buildCollisionShape(i, *vertices);
+  }
+}
+
+void Game::buildCollisionShape(size_t a_type, std::vector<float> const& a_vertices)
+{
+  m_collisionShapes[a_type] = Collision::build_shape(a_vertices);
+  Log::assets().debug("{}: bounding sphere {:.2f}, {} hull vertices", ARCHETYPE_TRAITS[a_type].modelPath,
+    m_collisionShapes[a_type].radius, m_collisionShapes[a_type].hull.size());
+}
+
+// The broadphase, the contacts and the debug boxes need a sphere around the entity position
+// that holds the whole mesh. The configured radius is only used for models without a shape.
+void Game::applyCollisionShapes()
+{
+  for (size_t i = 0; i < m_collisionShapes.size(); ++i) {
+    auto const& shape = m_collisionShapes[i];
+    auto const& archetype = m_archetypes[i];
+
+    if (shape.radius > 0.0f)
+      m_radiuses[i] = archetype.scale * (glm::length(shape.center) + shape.radius);
+    else
+      m_radiuses[i] = archetype.radius;
+  }
+}
+
+void Game::setupRandom()
+{
+  bool const deterministic = m_options.seed || m_settings.seed || !m_options.recordPath.empty() ||
+    !m_options.replayPath.empty() || m_options.headless;
+
+  m_seed = m_options.seed ? *m_options.seed : m_settings.seed;
+
+  if (!m_options.replayPath.empty()) {
+    m_replay = std::make_unique<ReplayPlayer>();
+    if (m_replay->open(m_options.replayPath)) {
+      m_seed = m_replay->seed();
+      if (m_replay->tick() != FIXED_TICK)
+        Log::game().warn("replay was recorded with a {} s tick, expect divergence", m_replay->tick());
+    } else {
+      m_replay.reset();
+    }
+  }
+
+  if (!m_seed) {
+    std::random_device rd{};
+    m_seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+  }
 
-  glEnable(GL_DEBUG_OUTPUT);
-  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS); 
-  glDebugMessageCallback(myGlDebugOutput, nullptr);
-  glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+  m_random.seed(m_seed);
+  m_fixedTimestep = deterministic;
+
+  if (!m_options.recordPath.empty()) {
+    m_recorder = std::make_unique<ReplayRecorder>();
+    if (!m_recorder->open(m_options.recordPath, m_seed, FIXED_TICK))
+      m_recorder.reset();
+  }
+
+  Log::game().info("Seed {}{}", m_seed, m_fixedTimestep ? " (fixed timestep)" : "");
 }
 
 
@@ -187,99 +329,358 @@ void Game::setupCamera()
   m_camera.offset = glm::vec3(0.0f, 50.0f, 18.0f);
 }
 
-void Game::setupPlayer()
+void Game::applyFramePacing()
 {
-  m_player = spawnEntity(m_models[static_cast<size_t>(EntityType::Player)], m_playerTexture);
+  if (m_options.headless)
+    return;
+
+  // the probe measures the frame time, waiting for vsync or the limiter would cap it at the target
+  if (m_capacityProbe) {
+    SDL_GL_SetSwapInterval(0);
+    m_frameLimiter.setTarget(0.0f, m_framePacing.spinMs);
+    return;
+  }
 
-  auto &physics = m_registry.get<Physics>(m_player);
-  physics.entityType = EntityType::Player;
+  if (SDL_GL_SetSwapInterval(m_framePacing.swapInterval) != 0) {
+    Log::render().warn("swap interval {} not supported: {}", m_framePacing.swapInterval, SDL_GetError());
+
+    // adaptive vsync is an extension, plain vsync is the closest
+    if (m_framePacing.swapInterval == -1 && SDL_GL_SetSwapInterval(1) == 0)
+      m_framePacing.swapInterval = 1;
+  }
+
+  m_frameLimiter.setTarget(m_framePacing.targetFps, m_framePacing.spinMs);
+}
+
+void Game::setupPlayer()
+{
+  m_player = spawnEntity(EntityType::Player, m_playerTexture);
 }
 
-entt::entity Game::spawnEntity(Model& a_model, Texture& a_texture)
+entt::entity Game::spawnEntity(EntityType a_type, Texture& a_texture)
 {
+  Physics physics{};
+  physics.entityType = a_type;
+
+  Memory::TagScope scope{ Memory::Category::Registry };
   auto entity = m_registry.create();
-  m_registry.assign<Model>(entity, a_model);
+  m_registry.assign<Model>(entity, m_models[static_cast<size_t>(a_type)]);
   m_registry.assign<Texture>(entity, a_texture);
-  m_registry.assign<Physics>(entity, Physics{});
+  m_registry.assign<Physics>(entity, physics);
+  Archetypes::assign_tag(m_registry, entity, a_type);
   return entity;
 }
 
-void Game::spawnAsteroids()
+// created at the next sync point, see applyCommands
+void Game::queueEntity(Physics const& a_physics, Texture const& a_texture)
+{
+  auto& commands = m_commands.getRecorder();
+
+  auto const entity = commands.create();
+  commands.assign(entity, m_models[static_cast<size_t>(a_physics.entityType)]);
+  commands.assign(entity, a_texture);
+  commands.assign(entity, a_physics);
+}
+
+void Game::applyCommands()
+{
+  m_commands.apply(m_registry);
+}
+
+void Game::spawnAsteroids(uint32_t a_count)
 {
-  //for (size_t i = 0; i < m_asteroidsAppearanceFrequency; ++i)
-    spawnAsteroid();
+  if (a_count == 0)
+    return;
+
+  auto& arena = m_frameAllocator.current();
+  auto const& playerPhysics = m_registry.get<Physics>(m_player);
+
+  FrameVector<AsteroidSpawn> spawns{ &arena };
+  SpawnScheduler::generate(a_count, playerPhysics.position, m_random, spawns);
+
+  for (auto const& spawn : spawns) {
+    Physics physics{};
+    physics.entityType = spawn.type;
+    physics.position = spawn.position;
+    physics.rotationAxis = spawn.rotationAxis;
+    physics.rotationVelocity = spawn.rotationVelocity;
+
+    queueEntity(physics, m_asteroidsTexture);
+  }
 }
 
 void Game::spawnAsteroid()
 {
-  std::uniform_int_distribution<size_t> randomAsteroidType(static_cast<size_t>(EntityType::AsteroidFragment), 
-    static_cast<size_t>(EntityType::AsteroidBig));
+  spawnAsteroids(1);
+}
+
+void Game::queueFragments(Physics const& a_asteroid, FrameVector<FragmentSpawn>& a_fragments)
+{
+  auto const type = static_cast<size_t>(a_asteroid.entityType);
+  int32_t const count = m_archetypes[type].fragments;
 
-  auto const modelIndex = randomAsteroidType(g_gen);
-  auto const type = static_cast<EntityType>(modelIndex);
+  if (a_asteroid.entityType == EntityType::AsteroidFragment || count <= 0)
+    return;
 
-  auto asteroid = spawnEntity(m_models[modelIndex], m_asteroidsTexture);
+  auto const fragmentType = static_cast<EntityType>(type - 1);
+  float const offset = m_radiuses[type] * 0.5f;
 
-  auto &playerPhysics = m_registry.get<Physics>(m_player);
-  auto &playerPos = playerPhysics.position;
+  for (int32_t i = 0; i < count; ++i) {
+    // spread evenly around the parent, jittered so the pieces don't look stamped out
+    float const jitter = m_random.range(-0.25f, 0.25f);
+    float const speed = m_random.range(FRAGMENT_SPEED_MIN, FRAGMENT_SPEED_MAX);
+
+    float const angle = glm::two_pi<float>() * (static_cast<float>(i) + jitter) / static_cast<float>(count);
+    glm::vec3 const direction{ std::cos(angle), 0.0f, std::sin(angle) };
+
+    FragmentSpawn fragment{};
+    fragment.type = fragmentType;
+    fragment.position = a_asteroid.position + direction * offset;
+    fragment.velocity = a_asteroid.velocity + direction * speed;
+    a_fragments.push_back(fragment);
+  }
+}
+
+void Game::spawnFragments(FrameVector<FragmentSpawn> const& a_fragments)
+{
+  if (a_fragments.empty())
+    return;
+
+  for (auto const& fragment : a_fragments) {
+    Physics physics{};
+    physics.entityType = fragment.type;
+    physics.position = fragment.position;
+    physics.velocity = fragment.velocity;
+
+    float const axisX = m_random.range(-1.0f, 1.0f);
+    float const axisY = m_random.range(-1.0f, 1.0f);
+    float const axisZ = m_random.range(-1.0f, 1.0f);
+    physics.rotationAxis = glm::vec3(axisX, axisY, axisZ);
+    physics.rotationVelocity = m_random.range(ASTEROID_ANGLE_VELOCITY_MIN, ASTEROID_ANGLE_VELOCITY_MAX);
+
+    queueEntity(physics, m_asteroidsTexture);
+  }
+}
+
+void Game::streamCorridor()
+{
+  float const playerZ = m_registry.get<Physics>(m_player).position.z;
 
-  auto &physics = m_registry.get<Physics>(asteroid);
-  physics.entityType = type;
+  ChunkDensity density{};
+  density.rate = m_settings.asteroidsAppearanceFrequency;
+  density.rateIncrease = m_settings.asteroidsApperanceIncrease;
+  density.forwardVelocity = m_settings.spaceshipForwardVelocity;
 
-  constexpr float distanceMinX = -20.0f;
-  constexpr float distanceMaxX = 20.0f;
+  while (auto chunk = m_asteroidField.takeActivation(playerZ, density))
+    activateChunk(*chunk);
 
-  constexpr float distanceMinZ = 40.0f;
-  constexpr float distanceMaxZ = 70.0f;
+  // lasers past the generated corridor have nothing left to hit
+  while (auto end = m_asteroidField.takeRetirement(playerZ))
+    retireEntities(*end, m_asteroidField.getFarZ());
+}
+
+void Game::activateChunk(AsteroidChunk const& a_chunk)
+{
+  size_t const count = a_chunk.types.size();
+  if (count == 0)
+    return;
+
+  for (size_t i = 0; i < count; ++i) {
+    Physics physics{};
+    physics.entityType = a_chunk.types[i];
+    physics.position = a_chunk.positions[i];
+    physics.rotationAxis = a_chunk.rotationAxes[i];
+    physics.rotationVelocity = a_chunk.rotationVelocities[i];
+
+    queueEntity(physics, m_asteroidsTexture);
+  }
+}
 
-  std::uniform_real_distribution asteroidPosX(playerPos.x + distanceMinX, playerPos.x + distanceMaxX);
-  std::uniform_real_distribution asteroidPosZ(playerPos.z + distanceMinZ, playerPos.z + distanceMaxZ);
-  std::uniform_real_distribution rotationAxis(-1.0f, 1.0f);
+void Game::retireEntities(float a_behindZ, float a_aheadZ)
+{
+  auto& commands = m_commands.getRecorder();
+
+  auto view = m_registry.view<Physics>();
+  for (auto entity : view) {
+    auto const& physics = view.get<Physics>(entity);
+    if (physics.entityType == EntityType::Player)
+      continue;
 
-  physics.position = glm::vec3(asteroidPosX(g_gen), 0.0f, asteroidPosZ(g_gen));
-  physics.rotationAxis = glm::vec3(rotationAxis(g_gen), rotationAxis(g_gen), rotationAxis(g_gen));
-  physics.rotationVelocity = g_asteroidAngleVelocity(g_gen);
+    if (physics.position.z < a_behindZ || (physics.entityType == EntityType::LaserBeam && physics.position.z > a_aheadZ))
+      commands.destroy(entity);
+  }
 }
 
 void Game::loadSettings()
+{
+  if (auto configData = Utils::open_file(CONFIG_PATH)) {
+    loadSettings(*configData);
+  } else {
+      Log::game().error("cant load config");
+  }
+}
+
+bool Game::loadSettings(std::string const& a_config)
 {
   using json = nlohmann::json;
 
-  if (auto configData = Utils::open_file("data/configs/config.json")) {
-    json config{ json::parse((*configData).data()) };
-    m_settings.cannonShootingFrequency = config["cannonShootingFrequency"].get<float>();
-    m_settings.cannonShootingVelocity = config["cannonShootingVelocity"].get<float>();
-    m_settings.spaceshipForwardVelocity = config["spaceshipForwardVelocity"].get<float>();
-    m_settings.engineThrust = config["engineThrust"].get<float>();
-    m_settings.spaceshipMass = config["spaceshipMass"].get<float>();
-    m_settings.asteroidsAppearanceFrequency = config["asteroidsAppearanceFrequency"].get<float>();
-    m_settings.asteroidsApperanceIncrease = config["asteroidsApperanceIncrease"].get<float>();
-
-    auto scales = config["scales"];
-    m_scales[static_cast<size_t>(EntityType::AsteroidFragment)] = scales["AsteroidFragment"].get<float>();
-    m_scales[static_cast<size_t>(EntityType::AsteroidSmall)] = scales["AsteroidSmall"].get<float>();
-    m_scales[static_cast<size_t>(EntityType::AsteroidMedium)] = scales["AsteroidMedium"].get<float>();
-    m_scales[static_cast<size_t>(EntityType::AsteroidBig)] = scales["AsteroidBig"].get<float>();
-    m_scales[static_cast<size_t>(EntityType::LaserBeam)] = scales["LaserBeam"].get<float>();
-    m_scales[static_cast<size_t>(EntityType::Player)] = scales["Player"].get<float>();
-
-    auto radius = config["radius"];
-    m_radiuses[static_cast<size_t>(EntityType::AsteroidFragment)] = radius["AsteroidFragment"].get<float>();
-    m_radiuses[static_cast<size_t>(EntityType::AsteroidMedium)] = radius["AsteroidMedium"].get<float>();
-    m_radiuses[static_cast<size_t>(EntityType::AsteroidSmall)] = radius["AsteroidSmall"].get<float>();
-    m_radiuses[static_cast<size_t>(EntityType::AsteroidBig)] = radius["AsteroidBig"].get<float>();
-    m_radiuses[static_cast<size_t>(EntityType::LaserBeam)] = radius["LaserBeam"].get<float>();
-    m_radiuses[static_cast<size_t>(EntityType::Player)] = scales["Player"].get<float>();
-
-
-    auto points = config["points"];
-    m_pointsPerAsteroid[static_cast<size_t>(EntityType::AsteroidFragment)] = points["AsteroidFragment"].get<int32_t>();
-    m_pointsPerAsteroid[static_cast<size_t>(EntityType::AsteroidMedium)] = points["AsteroidMedium"].get<int32_t>();
-    m_pointsPerAsteroid[static_cast<size_t>(EntityType::AsteroidSmall)] = points["AsteroidSmall"].get<int32_t>();
-    m_pointsPerAsteroid[static_cast<size_t>(EntityType::AsteroidBig)] = points["AsteroidBig"].get<int32_t>();
-  } else {
-      std::cerr << "cant load config";
+  json config{ json::parse(a_config, nullptr, false) };
+  if (config.is_discarded()) {
+    Log::game().error("invalid config");
+    return false;
+  }
+
+  // parse into copies so a half edited file keeps the previous values
+  Settings settings{ m_settings };
+  auto archetypes = DEFAULT_ARCHETYPES;
+  std::array<std::string, static_cast<size_t>(Log::Subsystem::Count)> logLevels{};
+  bool loggingEnabled{ Log::isEnabled() };
+  auto memoryBudgets = m_memoryBudgets;
+  ContactSettings contactSettings{ m_contactSettings };
+  SpatialSortSettings spatialSortSettings{ m_spatialSortSettings };
+  CapacitySettings capacitySettings{ m_capacitySettings };
+  CorridorSettings corridorSettings{ m_corridorSettings };
+  BroadphaseKind broadphaseKind{ m_broadphase->getKind() };
+  FramePacingSettings framePacing{ m_framePacing };
+  double memoryCsvInterval{ m_memoryCsvInterval };
+
+  try {
+    settings.cannonShootingFrequency = config["cannonShootingFrequency"].get<float>();
+    settings.cannonShootingVelocity = config["cannonShootingVelocity"].get<float>();
+    settings.spaceshipForwardVelocity = config["spaceshipForwardVelocity"].get<float>();
+    settings.engineThrust = config["engineThrust"].get<float>();
+    settings.spaceshipMass = config["spaceshipMass"].get<float>();
+    settings.asteroidsAppearanceFrequency = config["asteroidsAppearanceFrequency"].get<float>();
+    settings.asteroidsApperanceIncrease = config["asteroidsApperanceIncrease"].get<float>();
+    if (config.contains("seed"))
+      settings.seed = config["seed"].get<uint64_t>();
+    if (config.contains("pipelinedSimulation"))
+      settings.pipelinedSimulation = config["pipelinedSimulation"].get<bool>();
+
+    if (config.contains("hitscan"))
+      settings.hitscan = config["hitscan"].get<bool>();
+
+    if (config.contains("broadphase")) {
+      auto const name = config["broadphase"].get<std::string>();
+      auto const kind = get_broadphase_kind(name);
+      if (!kind) {
+        Log::game().error("invalid config: unknown broadphase {}", name);
+        return false;
+      }
+      broadphaseKind = *kind;
+    }
+
+    if (settings.cannonShootingFrequency <= 0.0f) {
+      Log::game().error("invalid config: cannonShootingFrequency must be positive");
+      return false;
+    }
+
+    // every value is optional, fragments are pieces of the next smaller type a shot asteroid breaks into
+    if (config.contains("archetypes")) {
+      auto archetypesConfig = config["archetypes"];
+      for (size_t i = 0; i < archetypes.size(); ++i) {
+        std::string const name{ ARCHETYPE_TRAITS[i].name };
+        if (!archetypesConfig.contains(name))
+          continue;
+
+        auto entry = archetypesConfig[name];
+        auto& archetype = archetypes[i];
+        archetype.scale = entry.value("scale", archetype.scale);
+        archetype.radius = entry.value("radius", archetype.radius);
+        archetype.points = entry.value("points", archetype.points);
+        archetype.fragments = entry.value("fragments", archetype.fragments);
+      }
+    }
+
+    if (config.contains("logging")) {
+      auto logging = config["logging"];
+      loggingEnabled = logging["enabled"].get<bool>();
+
+      auto levels = logging["levels"];
+      for (size_t i = 0; i < logLevels.size(); ++i) {
+        std::string const name{ Log::getSubsystemName(static_cast<Log::Subsystem>(i)) };
+        if (levels.contains(name))
+          logLevels[i] = levels[name].get<std::string>();
+      }
+    }
+
+    if (config.contains("asteroidContacts")) {
+      auto contacts = config["asteroidContacts"];
+      contactSettings.enabled = contacts["enabled"].get<bool>();
+      contactSettings.restitution = contacts["restitution"].get<float>();
+      contactSettings.density = contacts["density"].get<float>();
+      contactSettings.iterations = contacts["iterations"].get<uint32_t>();
+    }
+
+    if (config.contains("spatialSort")) {
+      auto spatialSort = config["spatialSort"];
+      spatialSortSettings.enabled = spatialSort["enabled"].get<bool>();
+      spatialSortSettings.interval = spatialSort["interval"].get<uint32_t>();
+      spatialSortSettings.threshold = spatialSort["threshold"].get<float>();
+      spatialSortSettings.cellSize = spatialSort["cellSize"].get<float>();
+    }
+
+    if (config.contains("framePacing")) {
+      auto pacing = config["framePacing"];
+      framePacing.swapInterval = pacing["swapInterval"].get<int>();
+      framePacing.targetFps = pacing["targetFps"].get<float>();
+      framePacing.spinMs = pacing["spinMs"].get<float>();
+    }
+
+    if (config.contains("corridor")) {
+      auto corridor = config["corridor"];
+      corridorSettings.chunkLength = corridor["chunkLength"].get<float>();
+      corridorSettings.width = corridor["width"].get<float>();
+      corridorSettings.startDistance = corridor["startDistance"].get<float>();
+      corridorSettings.activateDistance = corridor["activateDistance"].get<float>();
+      corridorSettings.retireDistance = corridor["retireDistance"].get<float>();
+      corridorSettings.lookahead = corridor["lookahead"].get<uint32_t>();
+    }
+
+    if (config.contains("capacity")) {
+      auto capacity = config["capacity"];
+      capacitySettings.budgetMs = capacity["budgetMs"].get<float>();
+      capacitySettings.bucketSize = capacity["bucketSize"].get<uint32_t>();
+      capacitySettings.rampRate = capacity["rampRate"].get<float>();
+      capacitySettings.maxEntities = capacity["maxEntities"].get<uint32_t>();
+      capacitySettings.minSamples = capacity["minSamples"].get<uint32_t>();
+    }
+
+    if (config.contains("memory")) {
+      auto memory = config["memory"];
+      memoryCsvInterval = memory["csvInterval"].get<double>();
+
+      // MiB, a missing category has no budget
+      auto budgets = memory["budgets"];
+      for (size_t i = 0; i < memoryBudgets.size(); ++i) {
+        std::string const name{ Memory::get_category_name(static_cast<Memory::Category>(i)) };
+        memoryBudgets[i] = budgets.contains(name) ? static_cast<int64_t>(budgets[name].get<double>() * MIB) : 0;
+      }
+    }
+  } catch (json::exception const& e) {
+    Log::game().error("invalid config: {}", e.what());
+    return false;
   }
+
+  m_settings = settings;
+  m_archetypes = archetypes;
+  m_memoryBudgets = memoryBudgets;
+  m_contactSettings = contactSettings;
+  m_spatialSortSettings = spatialSortSettings;
+  m_capacitySettings = capacitySettings;
+  m_corridorSettings = corridorSettings;
+  setBroadphase(broadphaseKind);
+  m_framePacing = framePacing;
+  m_memoryCsvInterval = memoryCsvInterval;
+  applyCollisionShapes();
+
+  for (size_t i = 0; i < logLevels.size(); ++i) {
+    if (!logLevels[i].empty())
+      Log::setLevel(static_cast<Log::Subsystem>(i), logLevels[i]);
+  }
+  Log::setEnabled(loggingEnabled);
+
+  return true;
 }
 
 void Game::saveSettings()
@@ -287,6 +688,104 @@ void Game::saveSettings()
 
 }
 
+void Game::applyAssetChanges()
+{
+  std::pair<std::string_view, Texture*> const textures[] = {
+    { "data/textures/asteroid.png", &m_asteroidsTexture },
+    { "data/textures/player.png", &m_playerTexture },
+    { "data/textures/laser_beam.png", &m_laserTexture },
+  };
+
+  for (auto& change : m_assetWatcher.takeChanges()) {
+    switch (change.kind) {
+      case AssetKind::Shader: {
+        Shader shader{};
+        if (!Utils::load_program(VERTEX_SHADER_PATH, FRAGMENT_SHADER_PATH, shader))
+          break;
+
+        glDeleteProgram(m_shader.program);
+        m_shader = shader;
+        glUseProgram(m_shader.program);
+
+        m_debugLineRenderer.loadShader();
+        break;
+      }
+      case AssetKind::Model: {
+        auto const type = Archetypes::find_by_model(change.path);
+        if (!type)
+          break;
+
+        Model const model = Utils::load_model(*change.model);
+        if (!model.vao)
+          break;
+
+        // every entity holds a copy of its model, repoint them before the old vao goes away
+        auto& current = m_models[static_cast<size_t>(*type)];
+        auto view = m_registry.view<Model>();
+        for (auto entity : view) {
+          auto& entityModel = view.get<Model>(entity);
+          if (entityModel.vao == current.vao)
+            entityModel = model;
+        }
+
+        for (auto& snapshot : m_snapshots) {
+          for (auto& item : snapshot.items) {
+            if (item.vao == current.vao) {
+              item.vao = model.vao;
+              item.vertices = model.vertices;
+            }
+          }
+        }
+
+        Utils::delete_model(current);
+        current = model;
+
+        m_collisionShapes[static_cast<size_t>(*type)] = Collision::build_shape(*change.model);
+        applyCollisionShapes();
+        break;
+      }
+      case AssetKind::Texture: {
+        auto const found = std::find_if(std::begin(textures), std::end(textures),
+          [&](auto const& texture) { return texture.first == change.path; });
+        if (found == std::end(textures))
+          break;
+
+        size_t bytes{};
+        Texture const texture = Utils::create_texture(*change.texture, bytes);
+        if (!texture.texture)
+          break;
+
+        auto& current = *found->second;
+        auto view = m_registry.view<Texture>();
+        for (auto entity : view) {
+          auto& entityTexture = view.get<Texture>(entity);
+          if (entityTexture.texture == current.texture)
+            entityTexture = texture;
+        }
+
+        for (auto& snapshot : m_snapshots) {
+          for (auto& item : snapshot.items) {
+            if (item.texture == current.texture)
+              item.texture = texture.texture;
+          }
+        }
+
+        Utils::delete_texture(current);
+        current = texture;
+        break;
+      }
+      case AssetKind::Config:
+        // other json files in the directory are not settings
+        if (change.path != CONFIG_PATH)
+          break;
+
+        if (loadSettings(*change.text))
+          applyFramePacing();
+        break;
+    }
+  }
+}
+
 void Game::handleWindowEvent(SDL_Event a_event)
 {
   //switch (a_event) {
@@ -296,6 +795,13 @@ void Game::handleWindowEvent(SDL_Event a_event)
 
 void Game::handleKeybordEvent(SDL_KeyboardEvent a_key, bool a_pressed)
 {
+  if (a_key.keysym.sym == SDLK_F1 && a_pressed && !a_key.repeat)
+    m_drawDebugUi = !m_drawDebugUi;
+
+  // a replay owns the controls
+  if (m_replay)
+    return;
+
   if (a_key.keysym.sym == SDLK_SPACE)
     m_keys[static_cast<size_t>(Key::Space)] = a_pressed;
   else if (a_key.keysym.sym == SDLK_LEFT)
@@ -306,45 +812,85 @@ void Game::handleKeybordEvent(SDL_KeyboardEvent a_key, bool a_pressed)
 
 bool Game::isAsteroid(EntityType a_type)
 {
-  return a_type == EntityType::AsteroidBig || a_type == EntityType::AsteroidFragment ||
-    a_type == EntityType::AsteroidMedium || a_type == EntityType::AsteroidSmall;
+  return Archetypes::is_asteroid(a_type);
 }
 
+// Tiered: the tight sphere of each mesh rejects most broadphase pairs, only pairs whose
+// spheres overlap pay for GJK on the hulls.
 bool Game::hasCollision(Physics const& entity1, Physics const& entity2)
 {
   auto const type1 = static_cast<size_t>(entity1.entityType);
   auto const type2 = static_cast<size_t>(entity2.entityType);
 
-  auto length = glm::length(entity1.position - entity2.position);
-  int l = static_cast<int>(length);
-  return length <= (m_radiuses[type1] + m_radiuses[type2]);
+  auto const& shape1 = m_collisionShapes[type1];
+  auto const& shape2 = m_collisionShapes[type2];
+
+  if (shape1.radius <= 0.0f || shape2.radius <= 0.0f) {
+    auto length = glm::length(entity1.position - entity2.position);
+    return length <= (m_radiuses[type1] + m_radiuses[type2]);
+  }
+
+  glm::mat4 const transform1{ getModelMatrix(entity1) };
+  glm::mat4 const transform2{ getModelMatrix(entity2) };
+
+  ++m_narrowphaseStats.spherePairs;
+
+  glm::vec3 const center1{ transform1 * glm::vec4(shape1.center, 1.0f) };
+  glm::vec3 const center2{ transform2 * glm::vec4(shape2.center, 1.0f) };
+  float const radius1 = shape1.radius * glm::length(glm::vec3(transform1[0]));
+  float const radius2 = shape2.radius * glm::length(glm::vec3(transform2[0]));
+
+  if (glm::length(center1 - center2) > radius1 + radius2)
+    return false;
+
+  if (shape1.hull.empty() || shape2.hull.empty())
+    return true;
+
+  ++m_narrowphaseStats.hullPairs;
+  return Collision::intersect(shape1, transform1, shape2, transform2);
+}
+
+// the simulation only keeps position and rotation, the matrix is built where it is needed
+glm::mat4 Game::getModelMatrix(Physics const& a_physics) const
+{
+  glm::mat4 matrix{ glm::translate(glm::mat4(1.0f), a_physics.position) };
+
+  if (Archetypes::get_traits(a_physics.entityType).rotates)
+    matrix = glm::rotate(matrix, glm::radians(a_physics.rotationAngle), a_physics.rotationAxis);
+
+  return glm::scale(matrix, glm::vec3(m_archetypes[static_cast<size_t>(a_physics.entityType)].scale));
 }
 
 void Game::gameLoop()
 {
+  if (m_options.headless) {
+    runHeadless();
+    finishRecording();
+    return;
+  }
+
   glEnable(GL_DEPTH_TEST);
 
 
   using clock_t = std::chrono::high_resolution_clock;
   auto start = clock_t::now();
   using duration = std::chrono::duration<double, std::milli>;
-  double asteroidSpawnTime{};
-  double lasersSpawnTime{};
-
-  double laserTimeDiff = 1.0 / m_settings.cannonShootingFrequency;
 
   glDepthMask(true);
   glUseProgram(m_shader.program);
 
   bool quit{};
 
-  m_projectionMatrix = glm::perspective(glm::radians(45.0f), 1280.0f/720.0f, 0.1f, 100.0f);
-
   float clearColor[3]{ 0.2f, 0.3f, 0.3f };
 
   reset();
 
-  while (!quit) {
+  while (!quit && !m_replayFinished) {
+    // the registry belongs to the simulation step started last frame until it is done
+    waitSimulation();
+
+    beginFrame();
+
     SDL_Event event{};
 
     if (SDL_PollEvent(&event)) {
@@ -365,6 +911,9 @@ void Game::gameLoop()
       };
     }
 
+    // reloaded assets are swapped in between frames only
+    applyAssetChanges();
+
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplSDL2_NewFrame(m_window);
     ImGui::NewFrame();
@@ -378,175 +927,479 @@ void Game::gameLoop()
     start = now;
     double delta{ deltaDuration.count() / 1000.0 };
 
-    if (m_gameState == GameState::Playing) {
-      asteroidSpawnTime += delta;
-
-      if (asteroidSpawnTime >= 1.0f) {
-        spawnAsteroids();
-        asteroidSpawnTime = 0.0f;
-      }
+    m_frameTimes[m_frameTimeIndex] = static_cast<float>(deltaDuration.count());
+    m_frameTimeIndex = (m_frameTimeIndex + 1) % m_frameTimes.size();
 
-      updateInput(delta);
+    if (m_capacityProbe && !m_capacityProbe->record(getEntityCount(), deltaDuration.count()))
+      quit = true;
 
-      if (m_shoot) {
-        if (lasersSpawnTime >= laserTimeDiff)
-          lasersSpawnTime = 0.0f;
+    trackMemory(delta);
 
-        if (lasersSpawnTime == 0.0)
-          shoot();
+    if (m_gameState == GameState::EndGame)
+      drawEndGame();
 
-        lasersSpawnTime += delta;
-      }
-      else
-        lasersSpawnTime = 0.0;
+    drawPoints();
 
-      updatePlayer(delta);
-      updateEntities(delta);
-      checkCollision();
-    } else {
-      drawEndGame();
+    if (m_drawDebugUi) {
+      debugDrawSystem();
+      debugDrawEntitiesTree();
+      debugDrawParams();
+      debugDrawMemory();
     }
 
-    updateCamera();
+    m_debugDraw.setEnabled(m_drawDebugBoxes || m_drawDebugBroadphase || m_drawDebugContacts || m_drawDebugRays);
 
-    drawEntities();
+    // Pipelined, the worker simulates this frame while the main thread draws the snapshot
+    // of the previous one: a frame costs max(simulation, render) instead of their sum and
+    // everything on screen is one frame older than the input that was just polled.
+    if (m_settings.pipelinedSimulation) {
+      m_simulationThread.run([this, delta] { simulate(delta); });
+      m_simulationRunning = true;
+    } else {
+      simulate(delta);
+      m_drawSnapshot ^= 1;
+    }
 
-    drawPoints();
+    auto const renderStart = clock_t::now();
 
-    //debugDrawSystem();
-    //debugDrawEntitiesTree();
-    //debugDrawParams();
+    auto const& snapshot = m_snapshots[m_drawSnapshot];
+    updateCamera(snapshot);
+    drawEntities(snapshot);
 
     ImGui::Render();
 
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
     SDL_GL_SwapWindow(m_window);
+
+    duration const renderTime = clock_t::now() - renderStart;
+    m_renderMs = renderTime.count();
+
+    m_frameLimiter.wait();
   }
 
+  waitSimulation();
+
+  finishRecording();
+  finishCapacity();
   saveSettings();
 }
 
-std::string_view Game::getEntityTypeName(EntityType a_type)
+void Game::simulate(double a_delta)
 {
-  switch (a_type)
-  {
-    case EntityType::AsteroidFragment: return "AsteroidFragment";
-    case EntityType::AsteroidSmall: return "AsteroidSmall";
-    case EntityType::AsteroidMedium: return "AsteroidMedium";
-    case EntityType::AsteroidBig: return "AsteroidBig";
-    case EntityType::Player: return "Player";
-    case EntityType::LaserBeam: return "LaserBeam";
-  }
+  using clock_t = std::chrono::high_resolution_clock;
+  using duration = std::chrono::duration<double, std::milli>;
 
-  return "<unknown>";
-}
+  auto const start = clock_t::now();
 
-void Game::updateInput(float a_delta)
-{
-  auto &physics = m_registry.get<Physics>(m_player);
+  if (m_fixedTimestep) {
+    m_tickAccumulator = std::min(m_tickAccumulator + a_delta, MAX_FRAME_TIME);
 
-  glm::vec3 const direction{ -1.0f, 0.0f, 0.0f };
+    while (m_tickAccumulator >= FIXED_TICK && !m_replayFinished) {
+      fixedTick();
+      m_tickAccumulator -= FIXED_TICK;
+    }
+  } else {
+    tick(a_delta);
+  }
 
-  if (m_keys[static_cast<size_t>(Key::Left)])
-    physics.position -= direction * m_camera.speed * a_delta;
+  duration const simulationTime = clock_t::now() - start;
+  m_simulationMs = simulationTime.count();
 
-  if (m_keys[static_cast<size_t>(Key::Right)])
-    physics.position += direction * m_camera.speed * a_delta;
+  auto const renderPrepStart = clock_t::now();
 
-  m_shoot = m_keys[static_cast<size_t>(Key::Space)];
+  auto& snapshot = m_snapshots[m_drawSnapshot ^ 1];
+  buildSnapshot(snapshot);
+
+  duration const renderPrepTime = clock_t::now() - renderPrepStart;
+  m_renderPrepMs = renderPrepTime.count();
+  m_renderCandidates = snapshot.candidates;
+  m_renderVisible = static_cast<uint32_t>(snapshot.items.size());
 }
 
-void Game::updatePlayer(float a_delta)
+void Game::waitSimulation()
 {
-  auto &model = m_registry.get<Model>(m_player);
-  auto &texture = m_registry.get<Texture>(m_player);
-  auto &physics = m_registry.get<Physics>(m_player);
+  if (!m_simulationRunning)
+    return;
 
-  physics.position += m_settings.spaceshipForwardVelocity * m_camera.direction * a_delta;
+  m_simulationThread.wait();
+  m_simulationRunning = false;
+  m_drawSnapshot ^= 1;
+}
+
+void Game::beginFrame()
+{
+  m_frameAllocator.beginFrame();
 
-  physics.modelMatrix = glm::mat4(1.0f);
-  physics.modelMatrix = glm::translate(physics.modelMatrix, physics.position);
+  uint64_t const allocationCount = Memory::get_allocation_count();
+  m_frameAllocations = allocationCount - m_frameAllocationCount;
+  m_frameAllocationCount = allocationCount;
 
-  physics.debugBoxMatrix = glm::mat4(1.0f);
-  physics.debugBoxMatrix = glm::translate(physics.debugBoxMatrix, physics.position);
-  physics.debugBoxMatrix = glm::scale(physics.debugBoxMatrix, glm::vec3(m_radiuses[static_cast<size_t>(physics.entityType)]));
+  m_commandStats = m_commands.takeStats();
 }
 
-void Game::updateEntities(float a_delta)
+void Game::tick(double a_delta)
 {
-  auto view = m_registry.view<Physics>();
+  if (m_gameState != GameState::Playing)
+    return;
 
-  for (auto entity : view) {
-    auto &physics = view.get<Physics>(entity);
+  // the capacity scenario ramps much faster than a regular game and never retires anything
+  if (m_capacityProbe) {
+    spawnAsteroids(m_spawnScheduler.update(a_delta, m_settings.asteroidsAppearanceFrequency,
+      m_capacitySettings.rampRate, m_random));
+  } else {
+    streamCorridor();
+  }
 
-    if (physics.entityType == EntityType::Player)
-      continue;
+  updateInput(a_delta);
 
-    physics.velocity += physics.acceleration * a_delta;
-    physics.position += physics.velocity * a_delta;
-    physics.rotationAngle += physics.rotationVelocity * a_delta;
-    
-    if (physics.rotationAngle >= 360.f)
-      physics.rotationAngle -= 360.f;
+  bool const canShoot = m_shoot && m_settings.cannonShootingFrequency > 0.0f;
 
-    physics.modelMatrix = glm::mat4(1.0f);
-    physics.modelMatrix = glm::translate(physics.modelMatrix, physics.position);
-    physics.modelMatrix = glm::rotate(physics.modelMatrix, glm::radians(physics.rotationAngle), physics.rotationAxis);
-    physics.modelMatrix = glm::scale(physics.modelMatrix, glm::vec3(m_scales[static_cast<size_t>(physics.entityType)]));
+  if (canShoot && m_settings.hitscan) {
+    // a hitscan shot is cheap enough to fire several per tick, here the timer counts down
+    double const laserTimeDiff = 1.0 / m_settings.cannonShootingFrequency;
+    uint32_t shots{};
 
-    physics.debugBoxMatrix = glm::mat4(1.0f);
-    physics.debugBoxMatrix = glm::translate(physics.debugBoxMatrix, physics.position);
-    physics.debugBoxMatrix = glm::scale(physics.debugBoxMatrix, glm::vec3(m_radiuses[static_cast<size_t>(physics.entityType)]));
-  }
-}
+    while (m_lasersSpawnTime <= 0.0) {
+      if (shots == MAX_SHOTS_PER_TICK) {
+        m_lasersSpawnTime = laserTimeDiff;
+        break;
+      }
+
+      shoot();
+      m_lasersSpawnTime += laserTimeDiff;
+      ++shots;
+    }
+
+    m_lasersSpawnTime -= a_delta;
+  }
+  else if (canShoot) {
+    double const laserTimeDiff = 1.0 / m_settings.cannonShootingFrequency;
+
+    if (m_lasersSpawnTime >= laserTimeDiff)
+      m_lasersSpawnTime = 0.0f;
+
+    if (m_lasersSpawnTime == 0.0)
+      shoot();
+
+    m_lasersSpawnTime += a_delta;
+  }
+  else
+    m_lasersSpawnTime = 0.0;
+
+  // sync point: entities spawned, shot or retired above take part in this tick
+  applyCommands();
+
+  updatePlayer(a_delta);
+  updateEntities(a_delta);
+  updateTracers(a_delta);
+  if (m_contactSettings.enabled)
+    resolveAsteroidContacts();
+  if (m_settings.hitscan)
+    updateAsteroidTree();
+  checkCollision();
+
+  // sync point: hits and their fragments
+  applyCommands();
 
-void Game::updateCamera()
+  logCollisions(a_delta);
+
+  // no view is alive here, the pools can be reordered
+  m_spatialSorter.update(m_registry, m_spatialSortSettings);
+}
+
+void Game::fixedTick()
+{
+  uint8_t input{};
+
+  if (m_replay) {
+    if (!m_replay->next(input)) {
+      finishReplay();
+      return;
+    }
+
+    if (input & REPLAY_RESET_BIT)
+      reset();
+
+    for (size_t i = 0; i < m_keys.size(); ++i)
+      m_keys[i] = (input >> i) & 1;
+  } else {
+    for (size_t i = 0; i < m_keys.size(); ++i)
+      input |= static_cast<uint8_t>(m_keys[i]) << i;
+
+    if (m_resetPending)
+      input |= REPLAY_RESET_BIT;
+  }
+
+  m_resetPending = false;
+
+  if (m_recorder)
+    m_recorder->record(input);
+
+  tick(FIXED_TICK);
+}
+
+void Game::runHeadless()
+{
+  reset();
+
+  if (m_replay) {
+    while (!m_replayFinished) {
+      beginFrame();
+      fixedTick();
+    }
+  } else if (m_capacityProbe) {
+    using clock_t = std::chrono::high_resolution_clock;
+    using duration = std::chrono::duration<double, std::milli>;
+
+    bool running{ true };
+    while (running) {
+      auto const start = clock_t::now();
+
+      beginFrame();
+      fixedTick();
+
+      duration const tickTime = clock_t::now() - start;
+      running = m_capacityProbe->record(getEntityCount(), tickTime.count());
+    }
+
+    finishCapacity();
+  } else {
+    for (uint32_t i = 0; i < m_options.ticks; ++i) {
+      beginFrame();
+      fixedTick();
+    }
+  }
+
+  Log::game().info("Final state {:016x} after {} points", stateHash(), m_points);
+}
+
+void Game::finishReplay()
+{
+  m_replayFinished = true;
+
+  auto const hash = stateHash();
+
+  if (hash == m_replay->stateHash()) {
+    Log::game().info("Replay finished after {} ticks, final state {:016x} matches", m_replay->ticks(), hash);
+  } else {
+    Log::game().error("Replay diverged: final state {:016x}, recorded {:016x}", hash, m_replay->stateHash());
+    m_replayFailed = true;
+  }
+}
+
+void Game::finishCapacity()
+{
+  if (!m_capacityProbe)
+    return;
+
+  if (m_capacityProbe->write(m_options.capacityPath))
+    Log::game().info("Capacity: {} entities within {:.2f} ms", m_capacityProbe->getCapacity(), m_capacitySettings.budgetMs);
+
+  m_capacityProbe.reset();
+}
+
+void Game::finishRecording()
+{
+  if (m_recorder) {
+    m_recorder->close(stateHash());
+    m_recorder.reset();
+  }
+}
+
+uint64_t Game::stateHash()
+{
+  uint64_t hash{ Utils::fnv1a(&m_points, sizeof(m_points)) };
+  hash = Utils::fnv1a(&m_gameState, sizeof(m_gameState), hash);
+
+  auto view = m_registry.view<Physics>();
+
+  for (auto entity : view) {
+    auto const& physics = view.get<Physics>(entity);
+
+    hash = Utils::fnv1a(&physics.position, sizeof(physics.position), hash);
+    hash = Utils::fnv1a(&physics.velocity, sizeof(physics.velocity), hash);
+    hash = Utils::fnv1a(&physics.rotationAngle, sizeof(physics.rotationAngle), hash);
+    hash = Utils::fnv1a(&physics.entityType, sizeof(physics.entityType), hash);
+  }
+
+  return hash;
+}
+
+bool Game::replayFailed() const
+{
+  return m_replayFailed;
+}
+
+bool Game::isPlaying() const
+{
+  return m_gameState == GameState::Playing;
+}
+
+size_t Game::getEntityCount()
+{
+  return m_registry.size<Physics>();
+}
+
+std::string_view Game::getEntityTypeName(EntityType a_type)
+{
+  if (a_type >= EntityType::Count)
+    return "<unknown>";
+
+  return Archetypes::get_traits(a_type).name;
+}
+
+void Game::updateInput(float a_delta)
 {
   auto &physics = m_registry.get<Physics>(m_player);
-  m_camera.pos = physics.position + m_camera.offset;
-  m_camera.pos.x = 0.0f;
 
-  glm::mat4 view{ glm::lookAt(m_camera.pos, m_camera.pos + m_camera.lookAt, m_camera.up) };
+  glm::vec3 const direction{ -1.0f, 0.0f, 0.0f };
 
-  uint32_t const modelLocation = glGetUniformLocation(m_shader.program, "view");
-  uint32_t const projectionLocation = glGetUniformLocation(m_shader.program, "projection");
+  if (m_keys[static_cast<size_t>(Key::Left)])
+    physics.position -= direction * m_camera.speed * a_delta;
 
-  glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(view));
-  glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix));
+  if (m_keys[static_cast<size_t>(Key::Right)])
+    physics.position += direction * m_camera.speed * a_delta;
+
+  // the capacity scenario keeps the cannon firing
+  m_shoot = m_keys[static_cast<size_t>(Key::Space)] || m_capacityProbe;
+}
+
+void Game::updatePlayer(float a_delta)
+{
+  auto &model = m_registry.get<Model>(m_player);
+  auto &texture = m_registry.get<Texture>(m_player);
+  auto &physics = m_registry.get<Physics>(m_player);
+
+  physics.position += m_settings.spaceshipForwardVelocity * m_camera.direction * a_delta;
+}
+
+void Game::updateEntities(float a_delta)
+{
+  updateKernel<EntityType::AsteroidFragment>(a_delta);
+  updateKernel<EntityType::AsteroidSmall>(a_delta);
+  updateKernel<EntityType::AsteroidMedium>(a_delta);
+  updateKernel<EntityType::AsteroidBig>(a_delta);
+  updateKernel<EntityType::LaserBeam>(a_delta);
+}
+
+// One type per call, the traits are constants and whatever a type doesn't do is compiled out.
+template<EntityType Type>
+void Game::updateKernel(float a_delta)
+{
+  constexpr ArchetypeTraits traits{ Archetypes::get_traits(Type) };
+  static_assert(traits.moves, "the type has its own update");
+
+  auto view = m_registry.view<Physics, TypeTag<Type>>();
+
+  for (auto entity : view) {
+    auto &physics = view.template get<Physics>(entity);
+
+    if constexpr (traits.accelerates)
+      physics.velocity += physics.acceleration * a_delta;
+
+    physics.position += physics.velocity * a_delta;
+
+    if constexpr (traits.rotates) {
+      physics.rotationAngle += physics.rotationVelocity * a_delta;
+
+      if (physics.rotationAngle >= 360.f)
+        physics.rotationAngle -= 360.f;
+    }
+  }
 }
 
-void Game::drawEntities()
+// Render prep: entities whose bounding sphere is outside the view frustum are skipped,
+// matrices are only built for what is drawn and go straight into the snapshot.
+void Game::buildSnapshot(RenderSnapshot& a_snapshot)
 {
+  auto &playerPhysics = m_registry.get<Physics>(m_player);
+  m_camera.pos = playerPhysics.position + m_camera.offset;
+  m_camera.pos.x = 0.0f;
+
+  a_snapshot.view = glm::lookAt(m_camera.pos, m_camera.pos + m_camera.lookAt, m_camera.up);
+
+  Frustum const frustum{ m_projectionMatrix * a_snapshot.view };
+
   auto view = m_registry.view<Texture, Model, Physics>();
 
-  int modelLoc{ glGetUniformLocation(m_shader.program, "model") };
+  a_snapshot.items.clear();
+  a_snapshot.items.reserve(m_registry.size<Physics>() + m_tracers.size());
+  a_snapshot.candidates = static_cast<uint32_t>(m_registry.size<Physics>() + m_tracers.size());
 
   for (auto entity : view) {
+    auto &physics = view.get<Physics>(entity);
+    float const radius = m_radiuses[static_cast<size_t>(physics.entityType)];
+
+    if (!frustum.intersectsSphere(physics.position, radius))
+      continue;
+
     auto &model = view.get<Model>(entity);
     auto &texture = view.get<Texture>(entity);
-    auto &physics = view.get<Physics>(entity);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture.texture);
-    glBindVertexArray(model.vao);
+    RenderItem item{};
+    item.vao = model.vao;
+    item.vertices = model.vertices;
+    item.texture = texture.texture;
+    item.modelMatrix = getModelMatrix(physics);
+    a_snapshot.items.push_back(item);
+
+    if (m_drawDebugBoxes)
+      m_debugDraw.box(physics.position - radius, physics.position + radius, DebugDraw::GREEN);
+  }
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(physics.modelMatrix));
+  auto const& laserModel = m_models[static_cast<size_t>(EntityType::LaserBeam)];
+  float const laserScale = m_archetypes[static_cast<size_t>(EntityType::LaserBeam)].scale;
+  float const laserRadius = m_radiuses[static_cast<size_t>(EntityType::LaserBeam)];
 
-    glDrawArrays(GL_TRIANGLES, 0, model.vertices);
+  for (auto const& tracer : m_tracers) {
+    if (!frustum.intersectsSphere(tracer.position, laserRadius))
+      continue;
 
-    if (m_drawDebugBoxes) {
-      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    RenderItem item{};
+    item.vao = laserModel.vao;
+    item.vertices = laserModel.vertices;
+    item.texture = m_laserTexture.texture;
+    item.modelMatrix = glm::scale(glm::translate(glm::mat4(1.0f), tracer.position), glm::vec3(laserScale));
+    a_snapshot.items.push_back(item);
+  }
 
-      auto& boxModel = m_models[static_cast<size_t>(EntityType::Box)];
+  if (m_debugDraw.isEnabled()) {
+    if (m_drawDebugBroadphase)
+      m_broadphase->drawDebug(m_debugDraw);
 
-      glBindVertexArray(boxModel.vao);
+    if (m_drawDebugContacts && m_contactSettings.enabled)
+      m_contactSolver.drawDebug(m_debugDraw);
+  }
 
-      glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(physics.debugBoxMatrix));
+  m_debugDraw.swap(a_snapshot.debugLines);
+}
 
-      glDrawArrays(GL_TRIANGLES, 0, model.vertices);
+void Game::updateCamera(RenderSnapshot const& a_snapshot)
+{
+  uint32_t const modelLocation = glGetUniformLocation(m_shader.program, "view");
+  uint32_t const projectionLocation = glGetUniformLocation(m_shader.program, "projection");
 
-      glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    }
+  glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(a_snapshot.view));
+  glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, glm::value_ptr(m_projectionMatrix));
+}
+
+void Game::drawEntities(RenderSnapshot const& a_snapshot)
+{
+  int modelLoc{ glGetUniformLocation(m_shader.program, "model") };
+
+  for (auto const& item : a_snapshot.items) {
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, item.texture);
+    glBindVertexArray(item.vao);
+
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(item.modelMatrix));
+
+    glDrawArrays(GL_TRIANGLES, 0, item.vertices);
+  }
+
+  if (!a_snapshot.debugLines.empty()) {
+    m_debugLineRenderer.draw(a_snapshot.debugLines, m_projectionMatrix * a_snapshot.view);
+    glUseProgram(m_shader.program);
   }
 }
 
@@ -561,99 +1414,401 @@ void Game::drawEndGame()
 {
   ImGui::Begin("##EndGame");
   ImGui::Text("You lost!");
-  if (ImGui::Button("Restart"))
+  if (!m_replay && ImGui::Button("Restart")) {
     reset();
+    m_resetPending = true;
+  }
   ImGui::End();
 }
 
-void Game::shoot()
+// a_distance starts the laser further along its path, as if it had been fired earlier
+void Game::shoot(float a_distance)
 {
-  auto entity = spawnEntity(m_models[static_cast<size_t>(EntityType::LaserBeam)], m_laserTexture);
+  if (m_settings.hitscan) {
+    shootHitscan();
+    return;
+  }
 
-  auto &playerPhysics = m_registry.get<Physics>(m_player);
+  auto const& playerPhysics = m_registry.get<Physics>(m_player);
 
-  auto &physics = m_registry.get<Physics>(entity);
+  Physics physics{};
   physics.entityType = EntityType::LaserBeam;
-
-  physics.position = playerPhysics.position;
+  physics.position = playerPhysics.position + glm::vec3(0.0f, 0.0f, a_distance);
   physics.velocity = glm::vec3(0.0f, 0.0f, m_settings.cannonShootingVelocity);
-  physics.rotationAxis= glm::vec3(0.0f, 0.0f, 1.0f);
+  physics.rotationAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+
+  queueEntity(physics, m_laserTexture);
+}
+
+// The laser hits the first asteroid along its path right away instead of flying there,
+// only a tracer is left to draw.
+void Game::shootHitscan()
+{
+  auto const& playerPhysics = m_registry.get<Physics>(m_player);
+
+  glm::vec3 const from{ playerPhysics.position };
+  glm::vec3 const to{ from + glm::vec3(0.0f, 0.0f, HITSCAN_RANGE) };
+  glm::vec3 const delta{ to - from };
+  float const laserRadius{ m_radiuses[static_cast<size_t>(EntityType::LaserBeam)] };
+
+  entt::entity hit{ entt::null };
+  float hitFraction{ 1.0f };
+
+  m_asteroidTree.rayCast(from, to, laserRadius, [&](int32_t a_proxy, float a_maxFraction) {
+    auto const entity = static_cast<entt::entity>(m_asteroidTree.getUserData(a_proxy));
+
+    // the tree is refit once per tick, asteroids destroyed since then are still in it
+    if (!m_registry.valid(entity) || m_commands.getRecorder().isDestroyed(entity))
+      return a_maxFraction;
+
+    auto const& physics = m_registry.get<Physics>(entity);
+    float const radius = m_radiuses[static_cast<size_t>(physics.entityType)] + laserRadius;
+
+    // first intersection of the segment with the sphere widened by the beam
+    glm::vec3 const offset{ from - physics.position };
+    float const a = glm::dot(delta, delta);
+    float const b = 2.0f * glm::dot(offset, delta);
+    float const c = glm::dot(offset, offset) - radius * radius;
+    float const discriminant = b * b - 4.0f * a * c;
+
+    if (discriminant < 0.0f)
+      return a_maxFraction;
+
+    float const fraction = std::max(0.0f, (-b - std::sqrt(discriminant)) / (2.0f * a));
+    if (fraction >= a_maxFraction || (-b + std::sqrt(discriminant)) < 0.0f)
+      return a_maxFraction;
+
+    hit = entity;
+    hitFraction = fraction;
+    return fraction;
+  });
+
+  m_tracers.push_back({ from + delta * hitFraction, TRACER_LIFETIME });
+
+  if (m_drawDebugRays)
+    m_debugDraw.line(from, from + delta * hitFraction, hit == entt::null ? DebugDraw::WHITE : DebugDraw::RED);
+
+  if (hit == entt::null)
+    return;
+
+  auto const& asteroid = m_registry.get<Physics>(hit);
+  auto const type = asteroid.entityType;
+
+  ++m_collisionCounts[static_cast<size_t>(EntityType::LaserBeam)][static_cast<size_t>(type)];
+
+  FrameVector<FragmentSpawn> fragments{ &m_frameAllocator.current() };
+  queueFragments(asteroid, fragments);
+
+  m_commands.getRecorder().destroy(hit);
+  m_points += m_archetypes[static_cast<size_t>(type)].points;
+
+  spawnFragments(fragments);
+}
+
+// Refits the tree from the current positions. Proxies are found by entity key, a stamp
+// tells which of them belong to asteroids that are gone.
+void Game::updateAsteroidTree()
+{
+  ++m_asteroidTreeStamp;
+
+  auto view = m_registry.view<Physics>();
+  for (auto entity : view) {
+    auto const& physics = view.get<Physics>(entity);
+    if (!isAsteroid(physics.entityType))
+      continue;
+
+    float const radius = m_radiuses[static_cast<size_t>(physics.entityType)];
+    Aabb const aabb{ physics.position - glm::vec3(radius), physics.position + glm::vec3(radius) };
+
+    uint32_t const key = get_entity_key(entity);
+    if (key >= m_asteroidProxies.size())
+      m_asteroidProxies.resize(static_cast<size_t>(key) + 1);
+
+    auto& slot = m_asteroidProxies[key];
+    if (slot.proxy == AabbTree::NULL_NODE) {
+      slot.proxy = m_asteroidTree.createProxy(aabb, static_cast<uint32_t>(entity));
+      m_asteroidProxyKeys.push_back(key);
+    } else {
+      // the key may have been reused by a new asteroid since the last refit
+      m_asteroidTree.setUserData(slot.proxy, static_cast<uint32_t>(entity));
+      m_asteroidTree.moveProxy(slot.proxy, aabb);
+    }
+
+    slot.stamp = m_asteroidTreeStamp;
+  }
+
+  for (size_t i = 0; i < m_asteroidProxyKeys.size();) {
+    auto& slot = m_asteroidProxies[m_asteroidProxyKeys[i]];
+    if (slot.stamp == m_asteroidTreeStamp) {
+      ++i;
+      continue;
+    }
+
+    m_asteroidTree.destroyProxy(slot.proxy);
+    slot.proxy = AabbTree::NULL_NODE;
+
+    m_asteroidProxyKeys[i] = m_asteroidProxyKeys.back();
+    m_asteroidProxyKeys.pop_back();
+  }
+}
+
+void Game::updateTracers(float a_delta)
+{
+  for (auto& tracer : m_tracers)
+    tracer.remaining -= a_delta;
+
+  m_tracers.erase(std::remove_if(m_tracers.begin(), m_tracers.end(),
+    [](Tracer const& a_tracer) { return a_tracer.remaining <= 0.0f; }), m_tracers.end());
+}
+
+void Game::setBroadphase(BroadphaseKind a_kind)
+{
+  if (m_broadphase->getKind() != a_kind)
+    m_broadphase = create_broadphase(a_kind);
 }
 
 void Game::checkCollision()
 {
   auto view = m_registry.view<Physics>();
+  auto& arena = m_frameAllocator.current();
+
+  FrameVector<BroadphaseProxy> proxies{ &arena };
+  proxies.reserve(view.size());
+
+  // by position in the view, the pairs index it the same way
+  for (size_t i = 0; i < view.size(); ++i) {
+    auto const entity = view[i];
+    auto const& physics = view.get<Physics>(entity);
+    proxies.push_back({ physics.position, m_radiuses[static_cast<size_t>(physics.entityType)], get_entity_key(entity) });
+  }
+
+  FrameVector<BroadphasePair> pairs{ &arena };
+  m_broadphase->findPairs(proxies.data(), proxies.size(), pairs);
+
+  // the order of the nested loop this replaced, hits and fragments don't depend on the broadphase
+  std::sort(pairs.begin(), pairs.end());
+
+  m_narrowphaseStats = {};
+  m_narrowphaseStats.broadphasePairs = static_cast<uint32_t>(pairs.size());
 
-  m_collided.clear();
+  FrameVector<std::pair<entt::entity, entt::entity>> collided{ &arena };
 
-  for (int i = 0; i < view.size(); ++i) {
-    auto entity1 = view[i];
+  for (auto const& pair : pairs) {
+    auto entity1 = view[pair.first];
     auto &physics1 = view.get<Physics>(entity1);
     auto const& type1 = physics1.entityType;
 
-    for (int j = i + 1; j < view.size(); ++j) {
-      auto entity2 = view[j];
-      auto &physics2 = view.get<Physics>(entity2);
-      auto const& type2 = physics2.entityType;
+    auto entity2 = view[pair.second];
+    auto &physics2 = view.get<Physics>(entity2);
+    auto const& type2 = physics2.entityType;
 
-      if (isAsteroid(type1) && isAsteroid(type2))
-        continue;
+    if (isAsteroid(type1) && isAsteroid(type2))
+      continue;
 
-      if (type1 == EntityType::LaserBeam && type2 == EntityType::LaserBeam)
-        continue;
+    if (type1 == EntityType::LaserBeam && type2 == EntityType::LaserBeam)
+      continue;
 
-      if ((type1 == EntityType::Player && type2 == EntityType::LaserBeam) ||
-          (type1 == EntityType::LaserBeam && type2 == EntityType::Player))
-        continue;
+    if ((type1 == EntityType::Player && type2 == EntityType::LaserBeam) ||
+        (type1 == EntityType::LaserBeam && type2 == EntityType::Player))
+      continue;
 
-      bool const collision = hasCollision(physics1, physics2);
+    bool const collision = hasCollision(physics1, physics2);
 
-      if (!collision)
-        continue;
+    if (!collision)
+      continue;
 
-      std::cout << "Collision between " << getEntityTypeName(type1) << " - " << getEntityTypeName(type2) << std::endl;
+    ++m_narrowphaseStats.hits;
+    ++m_collisionCounts[static_cast<size_t>(type1)][static_cast<size_t>(type2)];
 
-      if ((type1 == EntityType::LaserBeam && isAsteroid(type2)) ||
-          (isAsteroid(type1) && type2 == EntityType::LaserBeam)) {
-        m_collided.push_back(std::make_pair(entity1, entity2));
-      }
+    if ((type1 == EntityType::LaserBeam && isAsteroid(type2)) ||
+        (isAsteroid(type1) && type2 == EntityType::LaserBeam)) {
+      collided.push_back(std::make_pair(entity1, entity2));
+    }
 
-      if ((type1 == EntityType::Player && isAsteroid(type2)) ||
-          (isAsteroid(type1) && type2 == EntityType::Player)) {
+    if ((type1 == EntityType::Player && isAsteroid(type2)) ||
+        (isAsteroid(type1) && type2 == EntityType::Player)) {
+      // the capacity scenario must not end before the budget is missed
+      if (!m_capacityProbe)
         m_gameState = GameState::EndGame;
-      }
     }
   }
 
-  while (!m_collided.empty()) {
-    auto pair = m_collided.back();
+  // destroyed and created at the sync point after the pass, the view must not change while it is iterated
+  FrameVector<FragmentSpawn> fragments{ &m_frameAllocator.current() };
+  auto& commands = m_commands.getRecorder();
+
+  while (!collided.empty()) {
+    auto pair = collided.back();
     auto entity1 = pair.first;
     auto entity2 = pair.second;
 
-    auto type1 = view.get<Physics>(entity1).entityType;
-    auto type2= view.get<Physics>(entity2).entityType;
+    collided.pop_back();
+
+    // an asteroid hit by two lasers in the same pass is listed twice
+    if (commands.isDestroyed(entity1) || commands.isDestroyed(entity2))
+      continue;
+
+    auto const& physics1 = view.get<Physics>(entity1);
+    auto const& physics2 = view.get<Physics>(entity2);
+
+    auto const& asteroid = isAsteroid(physics1.entityType) ? physics1 : physics2;
+    auto const type = asteroid.entityType;
+
+    queueFragments(asteroid, fragments);
+
+    commands.destroy(entity1);
+    commands.destroy(entity2);
+
+    m_points += m_archetypes[static_cast<size_t>(type)].points;
+  }
+
+  spawnFragments(fragments);
+
+  m_narrowphaseTotals.broadphasePairs += m_narrowphaseStats.broadphasePairs;
+  m_narrowphaseTotals.spherePairs += m_narrowphaseStats.spherePairs;
+  m_narrowphaseTotals.hullPairs += m_narrowphaseStats.hullPairs;
+  m_narrowphaseTotals.hits += m_narrowphaseStats.hits;
+}
+
+// checkCollision leaves asteroid pairs alone, they bounce off each other here instead
+void Game::resolveAsteroidContacts()
+{
+  auto view = m_registry.view<Physics>();
+
+  FrameVector<entt::entity> entities{ &m_frameAllocator.current() };
+  FrameVector<ContactSolver::Body> bodies{ &m_frameAllocator.current() };
+  entities.reserve(view.size());
+  bodies.reserve(view.size());
+
+  for (auto entity : view) {
+    auto const& physics = view.get<Physics>(entity);
+    if (!isAsteroid(physics.entityType))
+      continue;
+
+    float const radius = m_radiuses[static_cast<size_t>(physics.entityType)];
+    float const mass = m_contactSettings.density * 4.0f / 3.0f * glm::pi<float>() * radius * radius * radius;
+
+    ContactSolver::Body body{};
+    body.position = physics.position;
+    body.velocity = physics.velocity;
+    body.radius = radius;
+    body.inverseMass = mass > 0.0f ? 1.0f / mass : 0.0f;
+
+    entities.push_back(entity);
+    bodies.push_back(body);
+  }
+
+  m_contactSolver.solve(bodies.data(), bodies.size(), m_contactSettings, m_jobs);
 
-    auto type = isAsteroid(type1) ? type1 : type2;
+  for (size_t i = 0; i < entities.size(); ++i) {
+    auto& physics = view.get<Physics>(entities[i]);
+    physics.position = bodies[i].position;
+    physics.velocity = bodies[i].velocity;
+  }
+}
 
-    m_registry.destroy(entity1);
-    m_registry.destroy(entity2);
+void Game::logCollisions(double a_delta)
+{
+  m_collisionLogTime += a_delta;
 
-    m_collided.pop_back();
+  if (m_collisionLogTime < COLLISION_LOG_INTERVAL)
+    return;
 
-    m_points += m_pointsPerAsteroid[static_cast<size_t>(type)];
+  // one line per type pair and interval instead of one per hit
+  for (size_t i = 0; i < m_collisionCounts.size(); ++i) {
+    for (size_t j = 0; j < m_collisionCounts[i].size(); ++j) {
+      if (auto const count = m_collisionCounts[i][j]) {
+        Log::collision().info("{} - {}: {:.1f}/s", getEntityTypeName(static_cast<EntityType>(i)),
+          getEntityTypeName(static_cast<EntityType>(j)), count / m_collisionLogTime);
+      }
+    }
   }
+
+  auto const& totals = m_narrowphaseTotals;
+  Log::collision().debug("pairs/s: {:.1f} broadphase, {:.1f} sphere, {:.1f} hull, {:.1f} hits",
+    totals.broadphasePairs / m_collisionLogTime, totals.spherePairs / m_collisionLogTime,
+    totals.hullPairs / m_collisionLogTime, totals.hits / m_collisionLogTime);
+
+  m_collisionCounts = {};
+  m_narrowphaseTotals = {};
+  m_collisionLogTime = 0.0;
+}
+
+void Game::trackMemory(double a_delta)
+{
+  for (size_t i = 0; i < m_memoryBudgets.size(); ++i) {
+    auto const category = static_cast<Memory::Category>(i);
+    bool const overBudget = m_memoryBudgets[i] > 0 && Memory::get_bytes(category) > m_memoryBudgets[i];
+
+    // warn once when crossing the budget, not every frame while above it
+    if (overBudget && !m_memoryOverBudget[i]) {
+      Log::game().warn("{} memory over budget: {:.2f} / {:.2f} MiB", Memory::get_category_name(category),
+        static_cast<double>(Memory::get_bytes(category)) / MIB, static_cast<double>(m_memoryBudgets[i]) / MIB);
+    }
+
+    m_memoryOverBudget[i] = overBudget;
+  }
+
+  m_memoryTime += a_delta;
+
+  if (m_memoryCsvInterval <= 0.0)
+    return;
+
+  m_memoryCsvTime += a_delta;
+  if (m_memoryCsvTime < m_memoryCsvInterval && m_memoryCsvStarted)
+    return;
+
+  m_memoryCsvTime = 0.0;
+
+  // a new session starts a new file
+  std::ofstream csv{ MEMORY_CSV_PATH, m_memoryCsvStarted ? std::ios::app : std::ios::trunc };
+  if (!csv) {
+    Log::game().warn("cannot write {}, memory dump disabled", MEMORY_CSV_PATH);
+    m_memoryCsvInterval = 0.0;
+    return;
+  }
+
+  if (!m_memoryCsvStarted) {
+    csv << "time";
+    for (size_t i = 0; i < m_memoryBudgets.size(); ++i)
+      csv << "," << Memory::get_category_name(static_cast<Memory::Category>(i));
+    csv << "\n";
+    m_memoryCsvStarted = true;
+  }
+
+  csv << m_memoryTime;
+  for (size_t i = 0; i < m_memoryBudgets.size(); ++i)
+    csv << "," << Memory::get_bytes(static_cast<Memory::Category>(i));
+  csv << "\n";
 }
 
 void Game::reset()
 {
+  m_random.seed(m_seed);
+  m_spawnScheduler.reset();
+  m_lasersSpawnTime = 0.0;
+
   m_gameState = GameState::Playing;
-  m_asteroidsAppearanceFrequency = m_settings.asteroidsAppearanceFrequency;
   m_points = 0;
 
-  m_registry.clear();
+  m_commands.clear();
+
+  {
+    Memory::TagScope scope{ Memory::Category::Registry };
+    m_registry.clear();
+    m_registry.reserve<Physics, Model, Texture>(ENTITY_RESERVE);
+  }
+
+  m_asteroidTree.clear();
+  m_asteroidProxies.clear();
+  m_asteroidProxyKeys.clear();
+  m_tracers.clear();
+  m_spatialSorter.reset();
 
   setupPlayer();
-  spawnAsteroids();
+
+  // chunk settings only change between games, a chunk is generated once
+  m_asteroidField.reset(m_seed, m_registry.get<Physics>(m_player).position.z, m_corridorSettings);
 }
 
 void Game::debugDrawSystem()
@@ -661,39 +1816,165 @@ void Game::debugDrawSystem()
   ImGuiIO& io = ImGui::GetIO();
 
   ImGui::Begin("System");
-  if (ImGui::Checkbox("Debug boxes", &m_drawDebugBoxes))
-  {
-
-  }
+  ImGui::Checkbox("Debug boxes", &m_drawDebugBoxes);
+  ImGui::SameLine();
+  ImGui::Checkbox("Broadphase", &m_drawDebugBroadphase);
+  ImGui::SameLine();
+  ImGui::Checkbox("Contacts", &m_drawDebugContacts);
+  ImGui::SameLine();
+  ImGui::Checkbox("Hitscan rays", &m_drawDebugRays);
   ImGui::Text("Frame time: %.3f ms", 1000.0f / io.Framerate);
   ImGui::Text("FPS: %.3f ms", io.Framerate);
+
+  float mean{};
+  for (auto const frameTime : m_frameTimes)
+    mean += frameTime;
+  mean /= m_frameTimes.size();
+
+  float variance{};
+  for (auto const frameTime : m_frameTimes)
+    variance += (frameTime - mean) * (frameTime - mean);
+  variance /= m_frameTimes.size();
+
+  ImGui::Text("Frame time mean: %.3f ms, stddev: %.3f ms", mean, std::sqrt(variance));
+
+  std::array<float, FRAME_HISTOGRAM_BUCKETS> histogram{};
+  for (auto const frameTime : m_frameTimes)
+    histogram[std::min(static_cast<size_t>(frameTime), histogram.size() - 1)] += 1.0f;
+
+  ImGui::PlotHistogram("##frameTimes", histogram.data(), static_cast<int>(histogram.size()), 0,
+    "frame times, 1 ms buckets", 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+
+  char const* const swapIntervals[]{ "Adaptive vsync", "Vsync off", "Vsync on" };
+  int swapInterval{ m_framePacing.swapInterval + 1 };
+  bool pacingChanged = ImGui::Combo("Swap interval", &swapInterval, swapIntervals, IM_ARRAYSIZE(swapIntervals));
+  pacingChanged |= ImGui::InputFloat("Target FPS (0 = off)", &m_framePacing.targetFps);
+
+  if (pacingChanged) {
+    m_framePacing.swapInterval = swapInterval - 1;
+    applyFramePacing();
+  }
+
+  // only switched here, between waitSimulation and the start of the next step
+  ImGui::Checkbox("Pipelined simulation", &m_settings.pipelinedSimulation);
+  ImGui::Text("Simulation: %.3f ms, render prep: %.3f ms, render: %.3f ms%s", m_simulationMs, m_renderPrepMs,
+    m_renderMs, m_settings.pipelinedSimulation ? ", +1 frame latency" : "");
+  ImGui::Text("Visible: %u of %u", m_renderVisible, m_renderCandidates);
+
+  auto const& arena = m_frameAllocator.current();
+  ImGui::Text("Frame arena: %zu KiB, high-water %zu / %zu KiB", arena.getUsed() / 1024,
+    arena.getHighWater() / 1024, arena.getCapacity() / 1024);
+
+  if (m_capacityProbe) {
+    ImGui::Text("Asteroid spawn rate: %.2f/s", m_spawnScheduler.getRate());
+  } else {
+    ImGui::Text("Corridor: %zu active chunks, %zu generated ahead", m_asteroidField.getActiveCount(),
+      m_asteroidField.getReadyCount());
+  }
+
+  int broadphase{ static_cast<int>(m_broadphase->getKind()) };
+  char const* const broadphases[]{ "Brute force", "Sweep and prune", "Grid" };
+  if (ImGui::Combo("Broadphase", &broadphase, broadphases, IM_ARRAYSIZE(broadphases)))
+    setBroadphase(static_cast<BroadphaseKind>(broadphase));
+
+  ImGui::Checkbox("Hitscan lasers", &m_settings.hitscan);
+  ImGui::Text("Narrowphase: %u pairs, %u sphere tests, %u hull tests, %u hits", m_narrowphaseStats.broadphasePairs,
+    m_narrowphaseStats.spherePairs, m_narrowphaseStats.hullPairs, m_narrowphaseStats.hits);
+
+  if (m_settings.hitscan)
+    ImGui::Text("Asteroid tree: %zu proxies, height %d", m_asteroidTree.getProxyCount(), m_asteroidTree.getHeight());
+
+  ImGui::Checkbox("Spatial sort", &m_spatialSortSettings.enabled);
+  if (m_spatialSortSettings.enabled) {
+    ImGui::Text("Storage disorder: %.2f, %u sorts, last %.3f ms", m_spatialSorter.getDisorder(),
+      m_spatialSorter.getSortCount(), m_spatialSorter.getLastSortMs());
+  }
+
+  if (m_contactSettings.enabled) {
+    ImGui::Text("Asteroid contacts: %zu in %zu colors, %zu threads", m_contactSolver.getContactCount(),
+      m_contactSolver.getColorCount(), m_jobs.getThreadCount());
+  }
+
+  ImGui::Text("Registry commands last frame: %u in %u applies, %.3f ms", m_commandStats.commands,
+    m_commandStats.applies, m_commandStats.applyMs);
+
+  if (Memory::is_tracking())
+    ImGui::Text("Heap allocations last frame: %llu", static_cast<unsigned long long>(m_frameAllocations));
+
+  bool loggingEnabled{ Log::isEnabled() };
+  if (ImGui::Checkbox("Logging", &loggingEnabled))
+    Log::setEnabled(loggingEnabled);
   ImGui::End();
 }
 
+// Rows are the filtered and sorted entities of the last complete refresh. The next refresh is
+// spread over frames and only the rows on screen are drawn, so the cost per frame stays flat.
 void Game::debugDrawEntitiesTree()
 {
+  static constexpr char const* sortModes[]{ "Storage", "Distance", "Velocity" };
+
+  std::array<char const*, static_cast<size_t>(EntityType::Count) + 1> filters{ "All" };
+  for (size_t i = 0; i < static_cast<size_t>(EntityType::Count); ++i)
+    filters[i + 1] = getEntityTypeName(static_cast<EntityType>(i)).data();
+
   ImGui::Begin("Entities");
 
-  auto view = m_registry.view<Physics>();
+  ImGui::PushItemWidth(120.0f);
+  bool changed = ImGui::Combo("Type", &m_inspectorFilter, filters.data(), static_cast<int>(filters.size()));
+  ImGui::SameLine();
+  changed |= ImGui::Combo("Sort", &m_inspectorSort, sortModes, IM_ARRAYSIZE(sortModes));
+  ImGui::PopItemWidth();
 
-  size_t const count = view.size();
+  if (changed) {
+    m_inspectorRows.restart(m_inspectorSort != 0);
+    m_inspectorScan = 0;
+  }
 
-  ImGui::Text("Count: %d", count);
+  updateInspectorRows();
 
-  for (size_t i = 0; i < count; ++i) {
-    auto entity = view[i];
-    auto &physics = view.get<Physics>(entity);
+  auto const& rows = m_inspectorRows.getRows();
 
-    if (ImGui::TreeNode((void*)(intptr_t)i, "Entity #%02d (%s)", i, getEntityTypeName(physics.entityType).data()))
-    {
-      ImGui::InputFloat3("position", glm::value_ptr(physics.position));
-      ImGui::InputFloat3("velocity", glm::value_ptr(physics.velocity));
-      ImGui::InputFloat3("rotationAxis", glm::value_ptr(physics.rotationAxis));
-      ImGui::InputFloat("rotationAngle", &physics.rotationAngle);
-      ImGui::InputFloat("rotationVelocity", &physics.rotationVelocity);
-      ImGui::TreePop();
+  ImGui::Text("Count: %zu, listed: %zu", m_registry.size<Physics>(), rows.size());
+
+  ImGui::BeginChild("rows", ImVec2(0.0f, -INSPECTOR_DETAILS_HEIGHT), true);
+
+  ImGuiListClipper clipper(static_cast<int>(rows.size()));
+  while (clipper.Step()) {
+    for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+      auto const entity = rows[i].entity;
+
+      // destroyed since the last refresh
+      if (!m_registry.valid(entity)) {
+        ImGui::TextDisabled("#%u", get_entity_key(entity));
+        continue;
+      }
+
+      auto const& physics = m_registry.get<Physics>(entity);
+
+      char label[64]{};
+      std::snprintf(label, sizeof(label), "#%u %s", get_entity_key(entity),
+        getEntityTypeName(physics.entityType).data());
+
+      ImGui::PushID(i);
+      if (ImGui::Selectable(label, entity == m_inspectorSelection))
+        m_inspectorSelection = entity;
+      ImGui::PopID();
     }
+  }
+
+  ImGui::EndChild();
+
+  if (m_registry.valid(m_inspectorSelection)) {
+    auto &physics = m_registry.get<Physics>(m_inspectorSelection);
 
+    ImGui::Text("Entity #%u (%s)", get_entity_key(m_inspectorSelection), getEntityTypeName(physics.entityType).data());
+    ImGui::InputFloat3("position", glm::value_ptr(physics.position));
+    ImGui::InputFloat3("velocity", glm::value_ptr(physics.velocity));
+    ImGui::InputFloat3("rotationAxis", glm::value_ptr(physics.rotationAxis));
+    ImGui::InputFloat("rotationAngle", &physics.rotationAngle);
+    ImGui::InputFloat("rotationVelocity", &physics.rotationVelocity);
+  } else {
+    ImGui::TextDisabled("Nothing selected");
   }
 
   ImGui::End();
@@ -706,13 +1987,52 @@ void Game::debugDrawEntitiesTree()
   ImGui::End();
 }
 
+// one slice of the next refresh: scan a part of the storage, then sort once all of it was seen
+void Game::updateInspectorRows()
+{
+  auto view = m_registry.view<Physics>();
+
+  if (m_inspectorScan >= view.size()) {
+    if (m_inspectorRows.finish(INSPECTOR_SORT_BUDGET)) {
+      m_inspectorRows.restart(m_inspectorSort != 0);
+      m_inspectorScan = 0;
+    }
+    return;
+  }
+
+  auto const& playerPosition = m_registry.get<Physics>(m_player).position;
+  size_t const end = std::min(view.size(), m_inspectorScan + INSPECTOR_SCAN_SLICE);
+
+  for (; m_inspectorScan < end; ++m_inspectorScan) {
+    auto const entity = view[m_inspectorScan];
+    auto const& physics = view.get<Physics>(entity);
+
+    if (m_inspectorFilter > 0 && physics.entityType != static_cast<EntityType>(m_inspectorFilter - 1))
+      continue;
+
+    // nearest or fastest first, storage order is kept as it is
+    float key{};
+    if (m_inspectorSort == 1)
+      key = glm::length(physics.position - playerPosition);
+    else if (m_inspectorSort == 2)
+      key = -glm::length(physics.velocity);
+
+    m_inspectorRows.add(key, entity);
+  }
+}
+
 void Game::debugDrawParams()
 {
   ImGui::Begin("Params");
   
   ImGui::PushItemWidth(70.0f);
 
-  ImGui::InputFloat("cannonShootingFrequency", &m_settings.cannonShootingFrequency);
+  // ctrl+click text entry bypasses the drag range, clamp it as well
+  if (ImGui::DragFloat("cannonShootingFrequency", &m_settings.cannonShootingFrequency, 0.1f, MIN_SHOOTING_FREQUENCY,
+    MAX_SHOOTING_FREQUENCY)) {
+    m_settings.cannonShootingFrequency = std::clamp(m_settings.cannonShootingFrequency, MIN_SHOOTING_FREQUENCY,
+      MAX_SHOOTING_FREQUENCY);
+  }
   ImGui::InputFloat("cannonShootingVelocity", &m_settings.cannonShootingVelocity);
   ImGui::InputFloat("spaceshipForwardVelocity", &m_settings.spaceshipForwardVelocity);
   ImGui::InputFloat("asteroidsAngularVelocityRange", &m_settings.asteroidsAngularVelocityRange);
@@ -723,23 +2043,78 @@ void Game::debugDrawParams()
 
   ImGui::Separator();
 
-  ImGui::InputFloat("scale.AsteroidFragment", &m_scales[static_cast<size_t>(EntityType::AsteroidFragment)]);
-  ImGui::InputFloat("scale.AsteroidSmall", &m_scales[static_cast<size_t>(EntityType::AsteroidSmall)]);
-  ImGui::InputFloat("scale.AsteroidMedium", &m_scales[static_cast<size_t>(EntityType::AsteroidMedium)]);
-  ImGui::InputFloat("scale.AsteroidBig", &m_scales[static_cast<size_t>(EntityType::AsteroidBig)]);
-  ImGui::InputFloat("scale.LaserBeam", &m_scales[static_cast<size_t>(EntityType::LaserBeam)]);
-  ImGui::InputFloat("scale.Player", &m_scales[static_cast<size_t>(EntityType::Player)]);
+  bool archetypesChanged{};
 
-  ImGui::Separator();
+  for (size_t i = 0; i < m_archetypes.size(); ++i) {
+    auto const& traits = ARCHETYPE_TRAITS[i];
+    if (traits.modelPath.empty())
+      continue;
+
+    auto& archetype = m_archetypes[i];
 
-  ImGui::InputFloat("radius.AsteroidFragment", &m_radiuses[static_cast<size_t>(EntityType::AsteroidFragment)]);
-  ImGui::InputFloat("radius.AsteroidSmall", &m_radiuses[static_cast<size_t>(EntityType::AsteroidSmall)]);
-  ImGui::InputFloat("radius.AsteroidMedium", &m_radiuses[static_cast<size_t>(EntityType::AsteroidMedium)]);
-  ImGui::InputFloat("radius.AsteroidBig", &m_radiuses[static_cast<size_t>(EntityType::AsteroidBig)]);
-  ImGui::InputFloat("radius.LaserBeam", &m_radiuses[static_cast<size_t>(EntityType::LaserBeam)]);
-  ImGui::InputFloat("radius.Player", &m_radiuses[static_cast<size_t>(EntityType::Player)]);
+    if (ImGui::TreeNode(traits.name.data())) {
+      archetypesChanged |= ImGui::InputFloat("scale", &archetype.scale);
+      archetypesChanged |= ImGui::InputFloat("radius", &archetype.radius);
+      ImGui::InputInt("points", &archetype.points);
+      ImGui::InputInt("fragments", &archetype.fragments);
+      ImGui::Text("collision radius: %.2f", m_radiuses[i]);
+      ImGui::TreePop();
+    }
+  }
+
+  if (archetypesChanged)
+    applyCollisionShapes();
   
   ImGui::PopItemWidth();
 
   ImGui::End();
 }
+
+void Game::debugDrawMemory()
+{
+  ImGui::Begin("Memory");
+
+  if (!Memory::is_tracking())
+    ImGui::Text("Heap tracking is only available in debug builds");
+
+  ImGui::Columns(4);
+  ImGui::Text("Category");
+  ImGui::NextColumn();
+  ImGui::Text("KiB");
+  ImGui::NextColumn();
+  ImGui::Text("Allocations");
+  ImGui::NextColumn();
+  ImGui::Text("Budget KiB");
+  ImGui::NextColumn();
+  ImGui::Separator();
+
+  for (size_t i = 0; i < m_memoryBudgets.size(); ++i) {
+    auto const category = static_cast<Memory::Category>(i);
+    auto const name = Memory::get_category_name(category);
+
+    if (m_memoryOverBudget[i])
+      ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "%.*s", static_cast<int>(name.size()), name.data());
+    else
+      ImGui::Text("%.*s", static_cast<int>(name.size()), name.data());
+    ImGui::NextColumn();
+    ImGui::Text("%lld", static_cast<long long>(Memory::get_bytes(category) / 1024));
+    ImGui::NextColumn();
+    ImGui::Text("%lld", static_cast<long long>(Memory::get_allocations(category)));
+    ImGui::NextColumn();
+    if (m_memoryBudgets[i] > 0)
+      ImGui::Text("%lld", static_cast<long long>(m_memoryBudgets[i] / 1024));
+    else
+      ImGui::Text("-");
+    ImGui::NextColumn();
+  }
+
+  ImGui::Columns(1);
+  ImGui::Separator();
+
+  for (auto const& storage : get_registry_storage(m_registry)) {
+    ImGui::Text("%.*s: %zu / %zu, %zu KiB", static_cast<int>(storage.name.size()), storage.name.data(),
+      storage.size, storage.capacity, storage.bytes / 1024);
+  }
+
+  ImGui::End();
+}
@@ -5,54 +5,126 @@
 #include <glad/glad.h>
 #include <string>
 #include <array>
+#include <memory>
+#include <vector>
 #include <entt/entt.hpp>
 #include <glm/matrix.hpp>
-
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "aabb_tree.h"
+#include "archetype.h"
+#include "asset_watcher.h"
+#include "asteroid_field.h"
+#include "broadphase.h"
+#include "capacity_probe.h"
+#include "collision.h"
+#include "command_buffer.h"
+#include "contact_solver.h"
+#include "debug_draw.h"
+#include "frame_arena.h"
+#include "frame_limiter.h"
+#include "frustum.h"
+#include "inspector_rows.h"
+#include "job_system.h"
+#include "memory_tracker.h"
+#include "random.h"
+#include "replay.h"
+#include "spatial_sort.h"
+#include "spawn_scheduler.h"
 #include "utils.h"
 
 class Game {
 public:
-  Game();
+  explicit Game(Options const& a_options = {});
   ~Game() = default;
 
+  void setupWindow();
+  void loadAssets();
+  void loadCollisionShapes();
+  void buildCollisionShape(size_t a_type, std::vector<float> const& a_vertices);
+  void applyCollisionShapes();
+  void setupRandom();
   void setupCamera();
   void setupPlayer();
+  void applyFramePacing();
 
-  entt::entity spawnEntity(Model& a_model, Texture& a_texture);
-  void spawnAsteroids();
+  entt::entity spawnEntity(EntityType a_type, Texture& a_texture);
+  void queueEntity(Physics const& a_physics, Texture const& a_texture);
+  void applyCommands();
+  void spawnAsteroids(uint32_t a_count);
   void spawnAsteroid();
+  void queueFragments(Physics const& a_asteroid, FrameVector<FragmentSpawn>& a_fragments);
+  void spawnFragments(FrameVector<FragmentSpawn> const& a_fragments);
+  void streamCorridor();
+  void activateChunk(AsteroidChunk const& a_chunk);
+  void retireEntities(float a_behindZ, float a_aheadZ);
 
   void loadSettings();
+  bool loadSettings(std::string const& a_config);
   void saveSettings();
 
+  void applyAssetChanges();
+
   void handleWindowEvent(SDL_Event a_event);
   void handleKeybordEvent(SDL_KeyboardEvent a_key, bool a_pressed);
   bool isAsteroid(EntityType a_type);
   bool hasCollision(Physics const& entity1, Physics const& entity2);
+  glm::mat4 getModelMatrix(Physics const& a_physics) const;
 
   void gameLoop();
+  void simulate(double a_delta);
+  void waitSimulation();
+  void beginFrame();
+  void tick(double a_delta);
+  void fixedTick();
+  void runHeadless();
+  void finishReplay();
+  void finishRecording();
+  void finishCapacity();
+
+  uint64_t stateHash();
+  bool replayFailed() const;
+  bool isPlaying() const;
+  size_t getEntityCount();
 
   std::string_view getEntityTypeName(EntityType a_type);
 
   void updateInput(float a_delta);
   void updatePlayer(float a_delta);
   void updateEntities(float a_delta);
-  void updateCamera();
-  void drawEntities();
+  template<EntityType Type>
+  void updateKernel(float a_delta);
+  void buildSnapshot(RenderSnapshot& a_snapshot);
+  void updateCamera(RenderSnapshot const& a_snapshot);
+  void drawEntities(RenderSnapshot const& a_snapshot);
   void drawPoints();
   void drawEndGame();
 
-  void shoot();
+  void shoot(float a_distance = 0.0f);
+  void shootHitscan();
+  void updateAsteroidTree();
+  void updateTracers(float a_delta);
+  void setHitscan(bool a_enabled) { m_settings.hitscan = a_enabled; }
+  void setSpatialSort(bool a_enabled) { m_spatialSortSettings.enabled = a_enabled; }
+  bool getSpatialSort() const { return m_spatialSortSettings.enabled; }
+  void setBroadphase(BroadphaseKind a_kind);
+  BroadphaseKind getBroadphase() const { return m_broadphase->getKind(); }
   void checkCollision();
+  void resolveAsteroidContacts();
+  void logCollisions(double a_delta);
+  void trackMemory(double a_delta);
 
   void reset();
 
   void debugDrawSystem();
   void debugDrawEntitiesTree();
+  void updateInspectorRows();
   void debugDrawParams();
+  void debugDrawMemory();
 
 
 private:
+  Options m_options{};
   SDL_Window* m_window{};
   SDL_GLContext m_context{};
   Shader m_shader{};
@@ -62,24 +134,107 @@ private:
   Texture m_playerTexture;
   Texture m_laserTexture;
   std::array<Model, static_cast<size_t>(EntityType::Count)> m_models{};
-  std::array<float, static_cast<size_t>(EntityType::Count)> m_scales{};
+  std::array<Archetype, static_cast<size_t>(EntityType::Count)> m_archetypes{ DEFAULT_ARCHETYPES };
+  // collision radius around the entity position, see applyCollisionShapes
   std::array<float, static_cast<size_t>(EntityType::Count)> m_radiuses{};
-  std::array<int32_t, static_cast<size_t>(EntityType::Count)> m_pointsPerAsteroid{};
+  std::array<CollisionShape, static_cast<size_t>(EntityType::Count)> m_collisionShapes{};
 
   entt::registry m_registry{};
+  CommandBuffer m_commands{};
+  CommandStats m_commandStats{};
   entt::entity m_player{};
 
-  glm::mat4 m_projectionMatrix{};
+  glm::mat4 m_projectionMatrix{ glm::perspective(glm::radians(45.0f), 1280.0f / 720.0f, 0.1f, 100.0f) };
 
   std::array<bool, static_cast<size_t>(Key::Count)> m_keys{};
-  std::vector<std::pair<entt::entity, entt::entity>> m_collided{};
   Settings m_settings{};
   uint32_t m_points{};
   GameState m_gameState{};
   bool m_shoot{};
   bool m_drawDebugBoxes{};
-
-  float m_asteroidsAppearanceFrequency{};
+  bool m_drawDebugBroadphase{};
+  bool m_drawDebugContacts{};
+  bool m_drawDebugRays{};
+  DebugDraw m_debugDraw{};
+  DebugLineRenderer m_debugLineRenderer{};
+
+  // Entities window: 0 lists every type, otherwise EntityType + 1; sort is storage, distance, velocity
+  InspectorRows m_inspectorRows{};
+  size_t m_inspectorScan{};
+  entt::entity m_inspectorSelection{ entt::null };
+  int m_inspectorFilter{};
+  int m_inspectorSort{};
+  bool m_drawDebugUi{};
+
+  std::array<std::array<uint32_t, static_cast<size_t>(EntityType::Count)>, static_cast<size_t>(EntityType::Count)> m_collisionCounts{};
+  double m_collisionLogTime{};
+  NarrowphaseStats m_narrowphaseStats{};
+  NarrowphaseStats m_narrowphaseTotals{};
+  std::array<float, 240> m_frameTimes{};
+  size_t m_frameTimeIndex{};
+
+  FramePacingSettings m_framePacing{};
+  FrameLimiter m_frameLimiter{};
+
+  FrameAllocator m_frameAllocator;
+  uint64_t m_frameAllocationCount{};
+  uint64_t m_frameAllocations{};
+
+  std::array<int64_t, static_cast<size_t>(Memory::Category::Count)> m_memoryBudgets{};
+  std::array<bool, static_cast<size_t>(Memory::Category::Count)> m_memoryOverBudget{};
+  double m_memoryCsvInterval{};
+  double m_memoryCsvTime{};
+  double m_memoryTime{};
+  bool m_memoryCsvStarted{};
+
+  SpawnScheduler m_spawnScheduler{};
+  AsteroidField m_asteroidField{};
+  CorridorSettings m_corridorSettings{};
+  double m_lasersSpawnTime{};
+
+  // asteroids for hitscan queries, proxies by entity key
+  struct AsteroidProxy {
+    int32_t proxy{ AabbTree::NULL_NODE };
+    uint32_t stamp{};
+  };
+  AabbTree m_asteroidTree{};
+  std::vector<AsteroidProxy> m_asteroidProxies{};
+  std::vector<uint32_t> m_asteroidProxyKeys{};
+  uint32_t m_asteroidTreeStamp{};
+  std::vector<Tracer> m_tracers{};
+
+  std::unique_ptr<Broadphase> m_broadphase{ create_broadphase(BroadphaseKind::SweepAndPrune) };
+  JobSystem m_jobs{};
+  ContactSolver m_contactSolver{};
+  ContactSettings m_contactSettings{};
+  SpatialSorter m_spatialSorter{};
+  SpatialSortSettings m_spatialSortSettings{};
+
+  Random m_random{};
+  uint64_t m_seed{};
+  bool m_fixedTimestep{};
+  bool m_resetPending{};
+  bool m_replayFinished{};
+  bool m_replayFailed{};
+  std::unique_ptr<ReplayRecorder> m_recorder{};
+  std::unique_ptr<ReplayPlayer> m_replay{};
+
+  CapacitySettings m_capacitySettings{};
+  std::unique_ptr<CapacityProbe> m_capacityProbe{};
+
+  AssetWatcher m_assetWatcher{};
+
+  // the simulation step of one frame overlaps the drawing of the previous one, see gameLoop
+  std::array<RenderSnapshot, 2> m_snapshots{};
+  size_t m_drawSnapshot{};
+  double m_tickAccumulator{};
+  double m_simulationMs{};
+  double m_renderPrepMs{};
+  uint32_t m_renderCandidates{};
+  uint32_t m_renderVisible{};
+  double m_renderMs{};
+  bool m_simulationRunning{};
+  WorkerThread m_simulationThread{};
 };
 
 #endif // GAME_H
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "inspector_rows.h"
+
+#include <algorithm>
+
+namespace {
+
+// sorted with std::sort before merging, small enough to stay within a frame's budget
+constexpr size_t RUN_SIZE = 1024;
+
+bool is_before(InspectorRows::Row const& a_lhs, InspectorRows::Row const& a_rhs)
+{
+  return a_lhs.key != a_rhs.key ? a_lhs.key < a_rhs.key : a_lhs.entity < a_rhs.entity;
+}
+
+} // namespace
+
+void InspectorRows::restart(bool a_sorted)
+{
+  m_building.clear();
+  m_sorted = a_sorted;
+  m_runsSorted = 0;
+  m_width = 0;
+}
+
+void InspectorRows::add(float a_key, entt::entity a_entity)
+{
+  m_building.push_back({ a_key, a_entity });
+}
+
+bool InspectorRows::finish(size_t a_budget)
+{
+  size_t const count = m_building.size();
+
+  if (m_sorted) {
+    bool sortedRun{};
+
+    // at least one run per call, however small the budget
+    while (m_runsSorted * RUN_SIZE < count) {
+      if (a_budget < RUN_SIZE && sortedRun)
+        return false;
+
+      auto const begin = m_building.begin() + m_runsSorted * RUN_SIZE;
+      auto const end = m_building.begin() + std::min((m_runsSorted + 1) * RUN_SIZE, count);
+      std::sort(begin, end, is_before);
+
+      ++m_runsSorted;
+      a_budget -= std::min(a_budget, RUN_SIZE);
+      sortedRun = true;
+    }
+
+    if (m_width == 0) {
+      m_width = RUN_SIZE;
+      beginPass();
+    }
+
+    if (!merge(a_budget))
+      return false;
+  }
+
+  m_rows.swap(m_building);
+  restart(m_sorted);
+  return true;
+}
+
+void InspectorRows::beginPass()
+{
+  m_scratch.resize(m_building.size());
+  m_start = 0;
+  m_left = 0;
+  m_right = std::min(m_width, m_building.size());
+  m_out = 0;
+}
+
+// merges neighbouring runs of m_width into m_scratch, one pass after the other
+bool InspectorRows::merge(size_t& a_budget)
+{
+  size_t const count = m_building.size();
+
+  while (m_width < count) {
+    if (m_start >= count) {
+      m_building.swap(m_scratch);
+      m_width *= 2;
+      beginPass();
+      continue;
+    }
+
+    size_t const middle = std::min(m_start + m_width, count);
+    size_t const end = std::min(m_start + 2 * m_width, count);
+
+    while (m_out < end) {
+      if (a_budget == 0)
+        return false;
+      --a_budget;
+
+      if (m_right >= end || (m_left < middle && !is_before(m_building[m_right], m_building[m_left])))
+        m_scratch[m_out++] = m_building[m_left++];
+      else
+        m_scratch[m_out++] = m_building[m_right++];
+    }
+
+    m_start = end;
+    m_left = end;
+    m_right = std::min(end + m_width, count);
+    m_out = end;
+  }
+
+  return true;
+}
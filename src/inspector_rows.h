@@ -0,0 +1,45 @@
+#ifndef INSPECTOR_ROWS_H
+#define INSPECTOR_ROWS_H
+
+#include <cstddef>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+// The rows of the Entities window, rebuilt a bounded amount of work at a time. Rows are added
+// over several frames, then sorted in runs and merged bottom-up with a merge that can stop after
+// any element. The shown rows stay in place until the new ones are complete and swap in.
+class InspectorRows {
+public:
+  struct Row {
+    float key{};
+    entt::entity entity{ entt::null };
+  };
+
+  // drops a build in progress, a_sorted false keeps the rows in the order they were added
+  void restart(bool a_sorted);
+  void add(float a_key, entt::entity a_entity);
+  // call once every row was added, spends about a_budget rows of work and returns true
+  // when the new rows were swapped in
+  bool finish(size_t a_budget);
+
+  std::vector<Row> const& getRows() const { return m_rows; }
+
+private:
+  bool merge(size_t& a_budget);
+  void beginPass();
+
+  std::vector<Row> m_rows{};
+  std::vector<Row> m_building{};
+  std::vector<Row> m_scratch{};
+  bool m_sorted{};
+  // runs sorted so far, then the state of the merge pass
+  size_t m_runsSorted{};
+  size_t m_width{};
+  size_t m_start{};
+  size_t m_left{};
+  size_t m_right{};
+  size_t m_out{};
+};
+
+#endif //INSPECTOR_ROWS_H
@@ -0,0 +1,174 @@
+#include "job_system.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(size_t a_workers)
+{
+  if (a_workers == 0) {
+    size_t const hardwareThreads = std::thread::hardware_concurrency();
+    a_workers = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+  }
+
+  for (size_t i = 0; i < a_workers; ++i)
+    m_workers.emplace_back(&JobSystem::run, this);
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard lock{ m_mutex };
+    m_stop = true;
+  }
+
+  m_wake.notify_all();
+
+  for (auto& worker : m_workers)
+    worker.join();
+}
+
+size_t JobSystem::getThreadCount() const
+{
+  return m_workers.size() + 1;
+}
+
+void JobSystem::parallelFor(size_t a_count, size_t a_minBatch, Function const& a_function)
+{
+  if (a_count == 0)
+    return;
+
+  size_t const threads = getThreadCount();
+  a_minBatch = std::max<size_t>(a_minBatch, 1);
+
+  if (threads == 1 || a_count <= a_minBatch) {
+    a_function(0, a_count);
+    return;
+  }
+
+  // a few batches per thread so an unlucky slow batch doesn't leave the others idle
+  size_t const batch = std::max(a_minBatch, (a_count + threads * 4 - 1) / (threads * 4));
+
+  {
+    std::lock_guard lock{ m_mutex };
+    m_function = &a_function;
+    m_count = a_count;
+    m_batch = batch;
+    m_next = 0;
+    m_pending = m_workers.size();
+    ++m_generation;
+  }
+
+  m_wake.notify_all();
+
+  work();
+
+  std::unique_lock lock{ m_mutex };
+  m_done.wait(lock, [this] { return m_pending == 0; });
+  m_function = nullptr;
+}
+
+void JobSystem::run()
+{
+  uint64_t generation{};
+
+  while (true) {
+    {
+      std::unique_lock lock{ m_mutex };
+      m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+
+      if (m_stop)
+        return;
+
+      generation = m_generation;
+    }
+
+    work();
+
+    bool last{};
+    {
+      std::lock_guard lock{ m_mutex };
+      last = --m_pending == 0;
+    }
+
+    if (last)
+      m_done.notify_one();
+  }
+}
+
+void JobSystem::work()
+{
+  while (true) {
+    size_t const begin = m_next.fetch_add(m_batch);
+    if (begin >= m_count)
+      return;
+
+    (*m_function)(begin, std::min(begin + m_batch, m_count));
+  }
+}
+
+WorkerThread::WorkerThread()
+  : m_thread{ &WorkerThread::loop, this }
+{
+}
+
+WorkerThread::~WorkerThread()
+{
+  wait();
+
+  {
+    std::lock_guard lock{ m_mutex };
+    m_stop = true;
+  }
+
+  m_wake.notify_one();
+  m_thread.join();
+}
+
+void WorkerThread::run(std::function<void()> a_task)
+{
+  {
+    std::lock_guard lock{ m_mutex };
+    m_task = std::move(a_task);
+    m_busy = true;
+  }
+
+  m_wake.notify_one();
+}
+
+void WorkerThread::wait()
+{
+  std::unique_lock lock{ m_mutex };
+  m_done.wait(lock, [this] { return !m_busy; });
+}
+
+bool WorkerThread::isBusy()
+{
+  std::lock_guard lock{ m_mutex };
+  return m_busy;
+}
+
+void WorkerThread::loop()
+{
+  while (true) {
+    std::function<void()> task{};
+
+    {
+      std::unique_lock lock{ m_mutex };
+      m_wake.wait(lock, [this] { return m_stop || m_task; });
+
+      if (m_stop)
+        return;
+
+      task = std::move(m_task);
+      m_task = nullptr;
+    }
+
+    task();
+
+    {
+      std::lock_guard lock{ m_mutex };
+      m_busy = false;
+    }
+
+    m_done.notify_all();
+  }
+}
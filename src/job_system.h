@@ -0,0 +1,78 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for data parallel loops. The calling thread takes part in
+// the work and parallelFor() returns only once every batch has run, so the caller may
+// read the results right away. Only one thread may issue work at a time.
+class JobSystem {
+public:
+  using Function = std::function<void(size_t a_begin, size_t a_end)>;
+
+  // 0 uses one worker less than the hardware threads, the caller makes up for it
+  explicit JobSystem(size_t a_workers = 0);
+  ~JobSystem();
+
+  JobSystem(JobSystem const&) = delete;
+  JobSystem& operator=(JobSystem const&) = delete;
+
+  // threads taking part in a parallelFor, the caller included
+  size_t getThreadCount() const;
+
+  // runs a_function over [0, a_count) in batches of at least a_minBatch elements
+  void parallelFor(size_t a_count, size_t a_minBatch, Function const& a_function);
+
+private:
+  void run();
+  void work();
+
+  std::vector<std::thread> m_workers{};
+
+  std::mutex m_mutex{};
+  std::condition_variable m_wake{};
+  std::condition_variable m_done{};
+  uint64_t m_generation{};
+  size_t m_pending{};
+  bool m_stop{};
+
+  Function const* m_function{};
+  size_t m_count{};
+  size_t m_batch{};
+  std::atomic<size_t> m_next{};
+};
+
+// One long-lived thread running a single task at a time, for work that overlaps with the
+// calling thread instead of splitting a loop. wait() must be called before the next run().
+class WorkerThread {
+public:
+  WorkerThread();
+  ~WorkerThread();
+
+  WorkerThread(WorkerThread const&) = delete;
+  WorkerThread& operator=(WorkerThread const&) = delete;
+
+  void run(std::function<void()> a_task);
+  void wait();
+  bool isBusy();
+
+private:
+  void loop();
+
+  std::mutex m_mutex{};
+  std::condition_variable m_wake{};
+  std::condition_variable m_done{};
+  std::function<void()> m_task{};
+  bool m_busy{};
+  bool m_stop{};
+  std::thread m_thread{};
+};
+
+#endif //JOB_SYSTEM_H
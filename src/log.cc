@@ -0,0 +1,95 @@
+#include "log.h"
+
+#include <array>
+#include <memory>
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+namespace {
+
+constexpr size_t QUEUE_SIZE = 8192;
+constexpr size_t LOG_THREADS = 1;
+
+std::array<std::shared_ptr<spdlog::logger>, static_cast<size_t>(Log::Subsystem::Count)> g_loggers{};
+std::array<spdlog::level::level_enum, static_cast<size_t>(Log::Subsystem::Count)> g_levels{};
+bool g_enabled{ true };
+
+} // namespace
+
+void Log::init()
+{
+  if (g_loggers[0])
+    return;
+
+  spdlog::init_thread_pool(QUEUE_SIZE, LOG_THREADS);
+  auto sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+
+  for (size_t i = 0; i < g_loggers.size(); ++i) {
+    std::string const name{ getSubsystemName(static_cast<Subsystem>(i)) };
+
+    g_loggers[i] = std::make_shared<spdlog::async_logger>(name, sink, spdlog::thread_pool(),
+      spdlog::async_overflow_policy::overrun_oldest);
+    g_loggers[i]->set_pattern("[%H:%M:%S.%e] [%n] [%^%l%$] %v");
+    g_loggers[i]->flush_on(spdlog::level::err);
+    g_levels[i] = spdlog::level::info;
+
+    spdlog::register_logger(g_loggers[i]);
+  }
+}
+
+void Log::shutdown()
+{
+  g_loggers = {};
+  spdlog::shutdown();
+}
+
+void Log::setLevel(Subsystem a_subsystem, std::string_view a_level)
+{
+  auto const index = static_cast<size_t>(a_subsystem);
+  auto const level = spdlog::level::from_str(std::string{ a_level });
+
+  // from_str answers off for names it doesn't know, a typo must not silence a subsystem
+  if (level == spdlog::level::off && a_level != "off") {
+    game().warn("unknown log level {} for {}, keeping {}", a_level, getSubsystemName(a_subsystem),
+      spdlog::level::to_string_view(g_levels[index]));
+    return;
+  }
+
+  g_levels[index] = level;
+
+  if (g_enabled)
+    g_loggers[index]->set_level(g_levels[index]);
+}
+
+void Log::setEnabled(bool a_enabled)
+{
+  g_enabled = a_enabled;
+
+  for (size_t i = 0; i < g_loggers.size(); ++i)
+    g_loggers[i]->set_level(a_enabled ? g_levels[i] : spdlog::level::off);
+}
+
+bool Log::isEnabled()
+{
+  return g_enabled;
+}
+
+spdlog::logger& Log::get(Subsystem a_subsystem)
+{
+  return *g_loggers[static_cast<size_t>(a_subsystem)];
+}
+
+std::string_view Log::getSubsystemName(Subsystem a_subsystem)
+{
+  switch (a_subsystem)
+  {
+    case Subsystem::Game: return "game";
+    case Subsystem::Render: return "render";
+    case Subsystem::Assets: return "assets";
+    case Subsystem::Collision: return "collision";
+    case Subsystem::Count: break;
+  }
+
+  return "<unknown>";
+}
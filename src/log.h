@@ -0,0 +1,40 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <string_view>
+
+#include <spdlog/spdlog.h>
+
+// All diagnostics go through asynchronous spdlog loggers, one per subsystem, so the
+// frame never waits on console output. Messages are formatted on the calling thread
+// and written by a single background thread; when its queue is full the oldest
+// messages are dropped instead of blocking.
+namespace Log {
+
+  enum class Subsystem {
+    Game,
+    Render,
+    Assets,
+    Collision,
+    Count
+  };
+
+  void init();
+  void shutdown();
+
+  void setLevel(Subsystem a_subsystem, std::string_view a_level);
+  void setEnabled(bool a_enabled);
+  bool isEnabled();
+
+  spdlog::logger& get(Subsystem a_subsystem);
+
+  inline spdlog::logger& game() { return get(Subsystem::Game); }
+  inline spdlog::logger& render() { return get(Subsystem::Render); }
+  inline spdlog::logger& assets() { return get(Subsystem::Assets); }
+  inline spdlog::logger& collision() { return get(Subsystem::Collision); }
+
+  std::string_view getSubsystemName(Subsystem a_subsystem);
+
+} // namespace Log
+
+#endif //LOG_H
@@ -1,15 +1,70 @@
 #include <cstdio>
 #include <cstdlib>
+#include <stdexcept>
+#include <string>
 
 #include <SDL.h>
 #include "game.h"
+#include "log.h"
 
+namespace {
 
+void print_usage()
+{
+  std::fprintf(stderr, "usage: SpaceshipGame [--seed <n>] [--record <file>] [--replay <file>] [--headless] "
+    "[--ticks <n>] [--capacity <base>]\n");
+}
+
+} // namespace
+
+// --seed <n>        deterministic run with a fixed seed and timestep
+// --record <file>   write the per-tick input stream to a replay file
+// --replay <file>   play a replay back and verify the final state hash
+// --headless        no window, simulate the replay or --ticks <n> ticks as fast as possible
+// --capacity <base> ramp up asteroids until the frame budget is missed, writes <base>.csv/.json
 int main(int argc, char **argv)
 {
-  Game game{};
-  game.gameLoop();
+  Log::init();
+
+  Options options{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg{ argv[i] };
+    bool const hasValue = i + 1 < argc;
+
+    // stoull/stoul throw invalid_argument and out_of_range, both are logic_errors
+    try {
+      if (arg == "--seed" && hasValue)
+        options.seed = std::stoull(argv[++i]);
+      else if (arg == "--record" && hasValue)
+        options.recordPath = argv[++i];
+      else if (arg == "--replay" && hasValue)
+        options.replayPath = argv[++i];
+      else if (arg == "--ticks" && hasValue)
+        options.ticks = static_cast<uint32_t>(std::stoul(argv[++i]));
+      else if (arg == "--capacity" && hasValue)
+        options.capacityPath = argv[++i];
+      else if (arg == "--headless")
+        options.headless = true;
+      else
+        Log::game().warn("unknown argument {}", arg);
+    }
+    catch (std::logic_error const&) {
+      Log::game().error("invalid value {} for {}", argv[i], arg);
+      print_usage();
+      Log::shutdown();
+      return 2;
+    }
+  }
+
+  bool failed{};
+
+  {
+    Game game{ options };
+    game.gameLoop();
+    failed = game.replayFailed();
+  }
 
-  
-  return EXIT_SUCCESS;
-}
\ No newline at end of file
+  Log::shutdown();
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
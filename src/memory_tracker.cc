@@ -0,0 +1,231 @@
+#include "memory_tracker.h"
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t CATEGORY_COUNT = static_cast<size_t>(Memory::Category::Count);
+
+std::atomic<uint64_t> g_allocationCount{};
+std::array<std::atomic<int64_t>, CATEGORY_COUNT> g_bytes{};
+std::array<std::atomic<int64_t>, CATEGORY_COUNT> g_allocations{};
+
+thread_local Memory::Category t_category{ Memory::Category::General };
+
+std::unordered_map<uint32_t, size_t>& get_gl_buffers()
+{
+  static std::unordered_map<uint32_t, size_t> buffers{};
+  return buffers;
+}
+
+std::unordered_map<uint32_t, size_t>& get_gl_textures()
+{
+  static std::unordered_map<uint32_t, size_t> textures{};
+  return textures;
+}
+
+void add(Memory::Category a_category, int64_t a_bytes, int64_t a_allocations)
+{
+  auto const index = static_cast<size_t>(a_category);
+  g_bytes[index].fetch_add(a_bytes, std::memory_order_relaxed);
+  g_allocations[index].fetch_add(a_allocations, std::memory_order_relaxed);
+}
+
+void track(std::unordered_map<uint32_t, size_t>& a_objects, Memory::Category a_category, uint32_t a_name,
+  size_t a_bytes)
+{
+  auto& bytes = a_objects[a_name];
+  add(a_category, static_cast<int64_t>(a_bytes) - static_cast<int64_t>(bytes), bytes ? 0 : 1);
+  bytes = a_bytes;
+}
+
+void untrack(std::unordered_map<uint32_t, size_t>& a_objects, Memory::Category a_category, uint32_t a_name)
+{
+  auto const found = a_objects.find(a_name);
+  if (found == a_objects.end())
+    return;
+
+  add(a_category, -static_cast<int64_t>(found->second), -1);
+  a_objects.erase(found);
+}
+
+#ifndef NDEBUG
+// Every block is prefixed with its size and category so operator delete can give the
+// bytes back to the category that allocated them, whichever thread frees it.
+struct alignas(std::max_align_t) Header {
+  size_t size{};
+  Memory::Category category{};
+};
+
+void* counted_allocate(std::size_t a_size)
+{
+  auto* header = static_cast<Header*>(std::malloc(sizeof(Header) + a_size));
+  if (!header)
+    return nullptr;
+
+  header->size = a_size;
+  header->category = t_category;
+
+  g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+  add(header->category, static_cast<int64_t>(a_size), 1);
+
+  return header + 1;
+}
+
+void counted_free(void* a_pointer)
+{
+  if (!a_pointer)
+    return;
+
+  auto* header = static_cast<Header*>(a_pointer) - 1;
+  add(header->category, -static_cast<int64_t>(header->size), -1);
+
+  std::free(header);
+}
+#endif
+
+} // namespace
+
+Memory::TagScope::TagScope(Category a_category)
+  : m_previous{ t_category }
+{
+  t_category = a_category;
+}
+
+Memory::TagScope::~TagScope()
+{
+  t_category = m_previous;
+}
+
+bool Memory::is_tracking()
+{
+#ifndef NDEBUG
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t Memory::get_allocation_count()
+{
+  return g_allocationCount.load(std::memory_order_relaxed);
+}
+
+int64_t Memory::get_bytes(Category a_category)
+{
+  return g_bytes[static_cast<size_t>(a_category)].load(std::memory_order_relaxed);
+}
+
+int64_t Memory::get_allocations(Category a_category)
+{
+  return g_allocations[static_cast<size_t>(a_category)].load(std::memory_order_relaxed);
+}
+
+void Memory::track_gl_buffer(uint32_t a_buffer, size_t a_bytes)
+{
+  track(get_gl_buffers(), Category::Buffers, a_buffer, a_bytes);
+}
+
+void Memory::untrack_gl_buffer(uint32_t a_buffer)
+{
+  untrack(get_gl_buffers(), Category::Buffers, a_buffer);
+}
+
+void Memory::track_gl_texture(uint32_t a_texture, size_t a_bytes)
+{
+  track(get_gl_textures(), Category::Textures, a_texture, a_bytes);
+}
+
+void Memory::untrack_gl_texture(uint32_t a_texture)
+{
+  untrack(get_gl_textures(), Category::Textures, a_texture);
+}
+
+void* Memory::imgui_allocate(size_t a_size, void* a_userData)
+{
+  TagScope scope{ Category::ImGui };
+  return ::operator new(a_size);
+}
+
+void Memory::imgui_free(void* a_pointer, void* a_userData)
+{
+  ::operator delete(a_pointer);
+}
+
+std::string_view Memory::get_category_name(Category a_category)
+{
+  switch (a_category)
+  {
+    case Category::General: return "general";
+    case Category::Assets: return "assets";
+    case Category::ImGui: return "imgui";
+    case Category::Registry: return "registry";
+    case Category::Buffers: return "buffers";
+    case Category::Textures: return "textures";
+    case Category::Count: break;
+  }
+
+  return "<unknown>";
+}
+
+#ifndef NDEBUG
+// the over-aligned overloads keep their default implementation, they never mix with these
+
+void* operator new(std::size_t a_size)
+{
+  if (void* pointer = counted_allocate(a_size))
+    return pointer;
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t a_size)
+{
+  if (void* pointer = counted_allocate(a_size))
+    return pointer;
+  throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t a_size, std::nothrow_t const&) noexcept
+{
+  return counted_allocate(a_size);
+}
+
+void* operator new[](std::size_t a_size, std::nothrow_t const&) noexcept
+{
+  return counted_allocate(a_size);
+}
+
+void operator delete(void* a_pointer) noexcept
+{
+  counted_free(a_pointer);
+}
+
+void operator delete[](void* a_pointer) noexcept
+{
+  counted_free(a_pointer);
+}
+
+void operator delete(void* a_pointer, std::size_t) noexcept
+{
+  counted_free(a_pointer);
+}
+
+void operator delete[](void* a_pointer, std::size_t) noexcept
+{
+  counted_free(a_pointer);
+}
+
+void operator delete(void* a_pointer, std::nothrow_t const&) noexcept
+{
+  counted_free(a_pointer);
+}
+
+void operator delete[](void* a_pointer, std::nothrow_t const&) noexcept
+{
+  counted_free(a_pointer);
+}
+#endif
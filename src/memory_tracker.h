@@ -0,0 +1,60 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Memory instrumentation. Debug builds replace the global operator new/delete to count
+// heap allocations and attribute their bytes to the category active on the allocating
+// thread (see TagScope), registry mutations are tagged as such. GPU memory is reported by
+// its owners.
+// In release builds the heap counters stay at zero and is_tracking() returns false.
+namespace Memory {
+
+  enum class Category {
+    General,
+    Assets,
+    ImGui,
+    Registry,
+    Buffers,
+    Textures,
+    Count
+  };
+
+  // heap allocations on this thread are attributed to a_category until the scope ends
+  class TagScope {
+  public:
+    explicit TagScope(Category a_category);
+    ~TagScope();
+
+    TagScope(TagScope const&) = delete;
+    TagScope& operator=(TagScope const&) = delete;
+
+  private:
+    Category m_previous{};
+  };
+
+  bool is_tracking();
+
+  // global operator new calls since the program started
+  uint64_t get_allocation_count();
+
+  int64_t get_bytes(Category a_category);
+  int64_t get_allocations(Category a_category);
+
+  // GL objects are tracked by name, main thread only like every other GL call
+  void track_gl_buffer(uint32_t a_buffer, size_t a_bytes);
+  void untrack_gl_buffer(uint32_t a_buffer);
+  void track_gl_texture(uint32_t a_texture, size_t a_bytes);
+  void untrack_gl_texture(uint32_t a_texture);
+
+  // ImGui allocator hooks, attribute everything ImGui allocates to Category::ImGui
+  void* imgui_allocate(size_t a_size, void* a_userData);
+  void imgui_free(void* a_pointer, void* a_userData);
+
+  std::string_view get_category_name(Category a_category);
+
+} // namespace Memory
+
+#endif //MEMORY_TRACKER_H
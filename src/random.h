@@ -0,0 +1,71 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// xoshiro128** seeded through splitmix64. Unlike the std distributions the mapping to
+// floats and ranges is spelled out here, so a seed produces the same sequence with
+// every compiler and standard library.
+class Random {
+public:
+  Random() = default;
+  explicit Random(uint64_t a_seed)
+  {
+    seed(a_seed);
+  }
+
+  void seed(uint64_t a_seed)
+  {
+    for (auto& state : m_state) {
+      a_seed += 0x9e3779b97f4a7c15ull;
+      uint64_t z = a_seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      state = static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+  }
+
+  uint32_t next()
+  {
+    uint32_t const result = rotl(m_state[1] * 5, 7) * 9;
+    uint32_t const t = m_state[1] << 9;
+
+    m_state[2] ^= m_state[0];
+    m_state[3] ^= m_state[1];
+    m_state[1] ^= m_state[2];
+    m_state[0] ^= m_state[3];
+    m_state[2] ^= t;
+    m_state[3] = rotl(m_state[3], 11);
+
+    return result;
+  }
+
+  // [0, 1) with 24 bits of precision
+  float nextFloat()
+  {
+    return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+  }
+
+  // [a_min, a_max)
+  float range(float a_min, float a_max)
+  {
+    return a_min + (a_max - a_min) * nextFloat();
+  }
+
+  // [a_min, a_max]
+  uint32_t range(uint32_t a_min, uint32_t a_max)
+  {
+    uint64_t const span = static_cast<uint64_t>(a_max) - a_min + 1;
+    return a_min + static_cast<uint32_t>((static_cast<uint64_t>(next()) * span) >> 32);
+  }
+
+private:
+  static uint32_t rotl(uint32_t a_value, int a_shift)
+  {
+    return (a_value << a_shift) | (a_value >> (32 - a_shift));
+  }
+
+  uint32_t m_state[4]{ 1, 2, 3, 4 };
+};
+
+#endif //RANDOM_H
@@ -0,0 +1,138 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "log.h"
+
+namespace {
+
+constexpr char REPLAY_MAGIC[4]{ 'S', 'G', 'R', 'P' };
+constexpr uint32_t REPLAY_VERSION = 1;
+
+struct ReplayHeader {
+  char magic[4]{};
+  uint32_t version{};
+  uint64_t seed{};
+  float tick{};
+  uint32_t ticks{};
+  uint32_t runs{};
+  uint32_t padding{};
+  uint64_t stateHash{};
+};
+
+} // namespace
+
+ReplayRecorder::~ReplayRecorder()
+{
+  if (m_file.is_open())
+    close(0);
+}
+
+bool ReplayRecorder::open(std::string_view a_path, uint64_t a_seed, float a_tick)
+{
+  m_file.open(a_path.data(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open()) {
+    Log::game().error("cannot create replay {}", a_path);
+    return false;
+  }
+
+  m_seed = a_seed;
+  m_tick = a_tick;
+
+  // placeholder, the real header is written on close
+  ReplayHeader const header{};
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  return true;
+}
+
+void ReplayRecorder::record(uint8_t a_input)
+{
+  if (m_runLength > 0 && (a_input != m_runInput || m_runLength == std::numeric_limits<uint16_t>::max()))
+    flushRun();
+
+  m_runInput = a_input;
+  ++m_runLength;
+  ++m_ticks;
+}
+
+void ReplayRecorder::close(uint64_t a_stateHash)
+{
+  if (m_runLength > 0)
+    flushRun();
+
+  auto const runsSize = static_cast<uint64_t>(m_file.tellp()) - sizeof(ReplayHeader);
+
+  ReplayHeader header{};
+  std::copy(std::begin(REPLAY_MAGIC), std::end(REPLAY_MAGIC), header.magic);
+  header.version = REPLAY_VERSION;
+  header.seed = m_seed;
+  header.tick = m_tick;
+  header.ticks = m_ticks;
+  header.runs = static_cast<uint32_t>(runsSize / 3);
+  header.stateHash = a_stateHash;
+
+  m_file.seekp(0);
+  m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  m_file.close();
+
+  Log::game().info("Replay recorded: {} ticks, final state {:016x}", m_ticks, a_stateHash);
+}
+
+void ReplayRecorder::flushRun()
+{
+  uint8_t const run[3]{ m_runInput, static_cast<uint8_t>(m_runLength & 0xff), static_cast<uint8_t>(m_runLength >> 8) };
+  m_file.write(reinterpret_cast<const char*>(run), sizeof(run));
+  m_runLength = 0;
+}
+
+bool ReplayPlayer::open(std::string_view a_path)
+{
+  std::ifstream fs{ a_path.data(), std::ios::in | std::ios::binary };
+  if (!fs.is_open()) {
+    Log::game().error("cannot open replay {}", a_path);
+    return false;
+  }
+
+  ReplayHeader header{};
+  fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (!fs || !std::equal(std::begin(REPLAY_MAGIC), std::end(REPLAY_MAGIC), header.magic) ||
+      header.version != REPLAY_VERSION) {
+    Log::game().error("invalid replay {}", a_path);
+    return false;
+  }
+
+  m_runs.resize(header.runs);
+  for (auto& run : m_runs) {
+    uint8_t data[3]{};
+    fs.read(reinterpret_cast<char*>(data), sizeof(data));
+    run = { data[0], static_cast<uint16_t>(data[1] | (data[2] << 8)) };
+  }
+
+  if (!fs) {
+    Log::game().error("truncated replay {}", a_path);
+    return false;
+  }
+
+  m_seed = header.seed;
+  m_tick = header.tick;
+  m_ticks = header.ticks;
+  m_stateHash = header.stateHash;
+  return true;
+}
+
+bool ReplayPlayer::next(uint8_t& a_input)
+{
+  while (m_run < m_runs.size() && m_runPosition >= m_runs[m_run].second) {
+    ++m_run;
+    m_runPosition = 0;
+  }
+
+  if (m_run >= m_runs.size())
+    return false;
+
+  a_input = m_runs[m_run].first;
+  ++m_runPosition;
+  return true;
+}
@@ -0,0 +1,54 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Replays store one input byte per simulation tick (bit i is Key i, the top bit marks
+// a game restart before the tick), run-length encoded. The header carries the seed and
+// tick length and is rewritten on close together with a hash of the final state.
+constexpr uint8_t REPLAY_RESET_BIT = 0x80;
+
+class ReplayRecorder {
+public:
+  ~ReplayRecorder();
+
+  bool open(std::string_view a_path, uint64_t a_seed, float a_tick);
+  void record(uint8_t a_input);
+  void close(uint64_t a_stateHash);
+
+private:
+  void flushRun();
+
+  std::ofstream m_file{};
+  uint64_t m_seed{};
+  float m_tick{};
+  uint32_t m_ticks{};
+  uint8_t m_runInput{};
+  uint16_t m_runLength{};
+};
+
+class ReplayPlayer {
+public:
+  bool open(std::string_view a_path);
+  bool next(uint8_t& a_input);
+
+  uint64_t seed() const { return m_seed; }
+  float tick() const { return m_tick; }
+  uint32_t ticks() const { return m_ticks; }
+  uint64_t stateHash() const { return m_stateHash; }
+
+private:
+  std::vector<std::pair<uint8_t, uint16_t>> m_runs{};
+  size_t m_run{};
+  uint16_t m_runPosition{};
+  uint64_t m_seed{};
+  float m_tick{};
+  uint32_t m_ticks{};
+  uint64_t m_stateHash{};
+};
+
+#endif //REPLAY_H
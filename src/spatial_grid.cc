@@ -0,0 +1,55 @@
+#include "spatial_grid.h"
+
+#include <algorithm>
+
+#include "debug_draw.h"
+
+void SpatialGrid::build(glm::vec3 const* a_positions, size_t a_count, float a_cellSize)
+{
+  m_cellSize = a_cellSize > 0.0f ? a_cellSize : 1.0f;
+  m_entries.resize(a_count);
+  m_cellStarts.clear();
+
+  float const inverseCellSize = 1.0f / m_cellSize;
+
+  for (size_t i = 0; i < a_count; ++i) {
+    auto const x = static_cast<int32_t>(std::floor(a_positions[i].x * inverseCellSize));
+    auto const z = static_cast<int32_t>(std::floor(a_positions[i].z * inverseCellSize));
+    m_entries[i] = { getCellKey(x, z), static_cast<uint32_t>(i) };
+  }
+
+  std::sort(m_entries.begin(), m_entries.end(), [](Entry const& a_lhs, Entry const& a_rhs) {
+    return a_lhs.cell != a_rhs.cell ? a_lhs.cell < a_rhs.cell : a_lhs.index < a_rhs.index;
+  });
+
+  for (size_t i = 0; i < m_entries.size(); ++i) {
+    if (i == 0 || m_entries[i].cell != m_entries[i - 1].cell)
+      m_cellStarts.push_back(static_cast<uint32_t>(i));
+  }
+}
+
+void SpatialGrid::drawDebug(DebugDraw& a_draw, float a_y, uint32_t a_color) const
+{
+  for (auto const start : m_cellStarts) {
+    uint64_t const key = m_entries[start].cell;
+    auto const x = static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+    auto const z = static_cast<int32_t>(static_cast<uint32_t>(key));
+    a_draw.gridCell(x, z, m_cellSize, a_y, a_color);
+  }
+}
+
+uint64_t SpatialGrid::getCellKey(int32_t a_x, int32_t a_z)
+{
+  return (static_cast<uint64_t>(static_cast<uint32_t>(a_x)) << 32) | static_cast<uint32_t>(a_z);
+}
+
+size_t SpatialGrid::findCell(uint64_t a_key) const
+{
+  auto const found = std::lower_bound(m_cellStarts.begin(), m_cellStarts.end(), a_key,
+    [this](uint32_t a_start, uint64_t a_value) { return m_entries[a_start].cell < a_value; });
+
+  if (found == m_cellStarts.end() || m_entries[*found].cell != a_key)
+    return m_cellStarts.size();
+
+  return static_cast<size_t>(found - m_cellStarts.begin());
+}
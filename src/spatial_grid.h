@@ -0,0 +1,80 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+class DebugDraw;
+
+// Uniform grid over the XZ plane the game is played in. Every sphere is binned by its
+// center only, so the cell size must be at least the largest diameter; two overlapping
+// spheres then always sit in the same or in neighbouring cells.
+class SpatialGrid {
+public:
+  void build(glm::vec3 const* a_positions, size_t a_count, float a_cellSize);
+
+  // calls a_function(i, j) with i != j once for every pair sharing or neighbouring a cell,
+  // in an order that only depends on the input
+  template<class Function>
+  void forEachPair(Function&& a_function) const;
+
+  size_t getCellCount() const { return m_cellStarts.size(); }
+
+  // outlines every occupied cell at a_y
+  void drawDebug(DebugDraw& a_draw, float a_y, uint32_t a_color) const;
+
+private:
+  struct Entry {
+    uint64_t cell{};
+    uint32_t index{};
+  };
+
+  static uint64_t getCellKey(int32_t a_x, int32_t a_z);
+  size_t findCell(uint64_t a_key) const;
+
+  float m_cellSize{ 1.0f };
+  std::vector<Entry> m_entries{};
+  // first entry of every occupied cell, the next start (or the end) closes it
+  std::vector<uint32_t> m_cellStarts{};
+};
+
+template<class Function>
+void SpatialGrid::forEachPair(Function&& a_function) const
+{
+  // half of the neighbourhood, the other half is covered from the other cell
+  constexpr int32_t neighbours[4][2]{ { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+  for (size_t cell = 0; cell < m_cellStarts.size(); ++cell) {
+    size_t const begin = m_cellStarts[cell];
+    size_t const end = cell + 1 < m_cellStarts.size() ? m_cellStarts[cell + 1] : m_entries.size();
+
+    for (size_t i = begin; i < end; ++i) {
+      for (size_t j = i + 1; j < end; ++j)
+        a_function(m_entries[i].index, m_entries[j].index);
+    }
+
+    uint64_t const key = m_entries[begin].cell;
+    auto const x = static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+    auto const z = static_cast<int32_t>(static_cast<uint32_t>(key));
+
+    for (auto const& neighbour : neighbours) {
+      size_t const other = findCell(getCellKey(x + neighbour[0], z + neighbour[1]));
+      if (other == m_cellStarts.size())
+        continue;
+
+      size_t const otherBegin = m_cellStarts[other];
+      size_t const otherEnd = other + 1 < m_cellStarts.size() ? m_cellStarts[other + 1] : m_entries.size();
+
+      for (size_t i = begin; i < end; ++i) {
+        for (size_t j = otherBegin; j < otherEnd; ++j)
+          a_function(m_entries[i].index, m_entries[j].index);
+      }
+    }
+  }
+}
+
+#endif //SPATIAL_GRID_H
@@ -0,0 +1,125 @@
+#include "spatial_sort.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <tuple>
+
+#include "archetype.h"
+#include "command_buffer.h"
+#include "data_types.h"
+
+namespace {
+
+constexpr int64_t AXIS_CELLS = int64_t{ 1 } << 21;
+
+// spaces the low 21 bits of a_value two bits apart
+uint64_t spread_bits(uint64_t a_value)
+{
+  a_value &= 0x1fffff;
+  a_value = (a_value | a_value << 32) & 0x1f00000000ffffull;
+  a_value = (a_value | a_value << 16) & 0x1f0000ff0000ffull;
+  a_value = (a_value | a_value << 8) & 0x100f00f00f00f00full;
+  a_value = (a_value | a_value << 4) & 0x10c30c30c30c30c3ull;
+  a_value = (a_value | a_value << 2) & 0x1249249249249249ull;
+  return a_value;
+}
+
+uint64_t quantize(float a_coordinate, float a_cellSize)
+{
+  auto const cell = static_cast<int64_t>(std::floor(a_coordinate / a_cellSize)) + AXIS_CELLS / 2;
+  return static_cast<uint64_t>(std::clamp<int64_t>(cell, 0, AXIS_CELLS - 1));
+}
+
+// the update kernels iterate a type from its tag pool, which has to follow Physics too
+template<EntityType... Types>
+void sort_tags(entt::registry& a_registry)
+{
+  (a_registry.sort<TypeTag<Types>, Physics>(), ...);
+}
+
+} // namespace
+
+uint64_t SpatialSort::morton_key(glm::vec3 const& a_position, float a_cellSize)
+{
+  return spread_bits(quantize(a_position.x, a_cellSize)) | spread_bits(quantize(a_position.y, a_cellSize)) << 1 |
+    spread_bits(quantize(a_position.z, a_cellSize)) << 2;
+}
+
+bool SpatialSorter::update(entt::registry& a_registry, SpatialSortSettings const& a_settings)
+{
+  if (!a_settings.enabled || ++m_ticks < a_settings.interval)
+    return false;
+
+  m_ticks = 0;
+  m_disorder = measure(a_registry, a_settings);
+
+  if (m_disorder <= a_settings.threshold)
+    return false;
+
+  // the keys were just measured
+  sortByKeys(a_registry);
+  return true;
+}
+
+void SpatialSorter::sort(entt::registry& a_registry, SpatialSortSettings const& a_settings)
+{
+  measure(a_registry, a_settings);
+  sortByKeys(a_registry);
+}
+
+void SpatialSorter::sortByKeys(entt::registry& a_registry)
+{
+  using clock_t = std::chrono::high_resolution_clock;
+  using duration = std::chrono::duration<double, std::milli>;
+
+  auto const start = clock_t::now();
+
+  // ties broken by entity so the order only depends on the game state
+  a_registry.sort<Physics>([this](entt::entity a_lhs, entt::entity a_rhs) {
+    auto const lhs = get_entity_key(a_lhs);
+    auto const rhs = get_entity_key(a_rhs);
+    return std::tie(m_keys[lhs], lhs) < std::tie(m_keys[rhs], rhs);
+  });
+  a_registry.sort<Model, Physics>();
+  a_registry.sort<Texture, Physics>();
+  sort_tags<EntityType::AsteroidFragment, EntityType::AsteroidSmall, EntityType::AsteroidMedium,
+    EntityType::AsteroidBig, EntityType::LaserBeam>(a_registry);
+
+  duration const sortTime = clock_t::now() - start;
+  m_lastSortMs = sortTime.count();
+  m_disorder = 0.0f;
+  ++m_sortCount;
+}
+
+void SpatialSorter::reset()
+{
+  m_ticks = 0;
+  m_disorder = 0.0f;
+}
+
+float SpatialSorter::measure(entt::registry& a_registry, SpatialSortSettings const& a_settings)
+{
+  auto view = a_registry.view<Physics>();
+
+  size_t descending{};
+  uint64_t previous{};
+  bool first{ true };
+
+  for (auto entity : view) {
+    uint32_t const key = get_entity_key(entity);
+    if (key >= m_keys.size())
+      m_keys.resize(static_cast<size_t>(key) + 1);
+
+    uint64_t const morton = SpatialSort::morton_key(view.get<Physics>(entity).position, a_settings.cellSize);
+    m_keys[key] = morton;
+
+    if (!first && morton < previous)
+      ++descending;
+
+    previous = morton;
+    first = false;
+  }
+
+  return view.size() > 1 ? static_cast<float>(descending) / static_cast<float>(view.size() - 1) : 0.0f;
+}
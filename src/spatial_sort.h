@@ -0,0 +1,55 @@
+#ifndef SPATIAL_SORT_H
+#define SPATIAL_SORT_H
+
+#include <cstdint>
+#include <vector>
+
+#include <entt/entt.hpp>
+#include <glm/vec3.hpp>
+
+struct SpatialSortSettings {
+  bool enabled{ true };
+  // ticks between two checks of the order
+  uint32_t interval{ 60 };
+  // fraction of storage neighbours out of Morton order that triggers a sort
+  float threshold{ 0.2f };
+  float cellSize{ 4.0f };
+};
+
+// Keeps the Physics storage in Z-order of the quantized positions, with Model, Texture and
+// the type tags aligned to it, so entities that are close in space are close in memory too. Spawning
+// and destroying scatters them again. The order is only measured every few ticks, and
+// only a storage that degraded past the threshold gets sorted.
+class SpatialSorter {
+public:
+  // true when the storage was sorted
+  bool update(entt::registry& a_registry, SpatialSortSettings const& a_settings);
+  void sort(entt::registry& a_registry, SpatialSortSettings const& a_settings);
+  void reset();
+
+  float getDisorder() const { return m_disorder; }
+  uint32_t getSortCount() const { return m_sortCount; }
+  double getLastSortMs() const { return m_lastSortMs; }
+
+private:
+  // refreshes m_keys and returns the fraction of neighbours out of order
+  float measure(entt::registry& a_registry, SpatialSortSettings const& a_settings);
+  // sorts by m_keys as the last measure left them
+  void sortByKeys(entt::registry& a_registry);
+
+  // Morton keys by entity key
+  std::vector<uint64_t> m_keys{};
+  uint32_t m_ticks{};
+  float m_disorder{};
+  uint32_t m_sortCount{};
+  double m_lastSortMs{};
+};
+
+namespace SpatialSort {
+
+  // 21 bits per axis around the origin, interleaved as zyx
+  uint64_t morton_key(glm::vec3 const& a_position, float a_cellSize);
+
+} // namespace SpatialSort
+
+#endif //SPATIAL_SORT_H
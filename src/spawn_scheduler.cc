@@ -0,0 +1,72 @@
+#include "spawn_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// a stalled frame (debugger, window drag) must not dump minutes worth of asteroids at once
+constexpr uint32_t MAX_SPAWNS_PER_TICK = 256;
+
+constexpr float DISTANCE_MIN_X = -20.0f;
+constexpr float DISTANCE_MAX_X = 20.0f;
+
+constexpr float DISTANCE_MIN_Z = 40.0f;
+constexpr float DISTANCE_MAX_Z = 70.0f;
+
+} // namespace
+
+void SpawnScheduler::reset()
+{
+  m_time = 0.0;
+  m_nextSpawn = 0.0;
+  m_rate = 0.0;
+}
+
+uint32_t SpawnScheduler::update(double a_delta, float a_rate, float a_rateIncrease, Random& a_random)
+{
+  m_time += a_delta;
+  m_rate = std::max(0.0, static_cast<double>(a_rate) + static_cast<double>(a_rateIncrease) * m_time);
+
+  if (m_rate <= 0.0) {
+    m_nextSpawn = m_time;
+    return 0;
+  }
+
+  uint32_t count{};
+
+  while (m_nextSpawn <= m_time) {
+    if (count == MAX_SPAWNS_PER_TICK) {
+      m_nextSpawn = m_time;
+      break;
+    }
+
+    // exponential inter-arrival times, nextFloat() < 1 keeps the log finite
+    m_nextSpawn += -std::log(1.0 - a_random.nextFloat()) / m_rate;
+    ++count;
+  }
+
+  return count;
+}
+
+void SpawnScheduler::generate(uint32_t a_count, glm::vec3 const& a_origin, Random& a_random,
+  FrameVector<AsteroidSpawn>& a_spawns)
+{
+  a_spawns.resize(a_count);
+
+  // one draw per statement, argument evaluation order is unspecified
+  for (auto& spawn : a_spawns) {
+    spawn.type = static_cast<EntityType>(a_random.range(static_cast<uint32_t>(EntityType::AsteroidFragment),
+      static_cast<uint32_t>(EntityType::AsteroidBig)));
+
+    float const posX = a_random.range(a_origin.x + DISTANCE_MIN_X, a_origin.x + DISTANCE_MAX_X);
+    float const posZ = a_random.range(a_origin.z + DISTANCE_MIN_Z, a_origin.z + DISTANCE_MAX_Z);
+    float const axisX = a_random.range(-1.0f, 1.0f);
+    float const axisY = a_random.range(-1.0f, 1.0f);
+    float const axisZ = a_random.range(-1.0f, 1.0f);
+
+    spawn.position = glm::vec3(posX, 0.0f, posZ);
+    spawn.rotationAxis = glm::vec3(axisX, axisY, axisZ);
+    spawn.rotationVelocity = a_random.range(ASTEROID_ANGLE_VELOCITY_MIN, ASTEROID_ANGLE_VELOCITY_MAX);
+  }
+}
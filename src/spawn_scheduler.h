@@ -0,0 +1,38 @@
+#ifndef SPAWN_SCHEDULER_H
+#define SPAWN_SCHEDULER_H
+
+#include <cstdint>
+
+#include <glm/vec3.hpp>
+
+#include "data_types.h"
+#include "frame_arena.h"
+#include "random.h"
+
+constexpr float ASTEROID_ANGLE_VELOCITY_MIN = 10.05f;
+constexpr float ASTEROID_ANGLE_VELOCITY_MAX = 30.5f;
+
+// Asteroids arrive as a Poisson process whose rate starts at asteroidsAppearanceFrequency
+// and grows by asteroidsApperanceIncrease every second, so the pressure keeps rising the
+// longer a game lasts. Regular games stream an AsteroidField instead, with a steep increase
+// this is the load ramp of the capacity scenario.
+class SpawnScheduler {
+public:
+  void reset();
+
+  // asteroids due during this tick, rates are per second
+  uint32_t update(double a_delta, float a_rate, float a_rateIncrease, Random& a_random);
+
+  double getRate() const { return m_rate; }
+
+  // all parameters of a batch in one pass, ahead of creating any entity
+  static void generate(uint32_t a_count, glm::vec3 const& a_origin, Random& a_random,
+    FrameVector<AsteroidSpawn>& a_spawns);
+
+private:
+  double m_time{};
+  double m_nextSpawn{};
+  double m_rate{};
+};
+
+#endif //SPAWN_SCHEDULER_H
@@ -0,0 +1,450 @@
+#include "texture_cooker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+#include "log.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace {
+
+constexpr char COOKED_MAGIC[4]{ 'K', 'T', 'E', 'X' };
+constexpr uint32_t COOKED_VERSION = 1;
+
+struct CookedHeader {
+  char magic[4]{};
+  uint32_t version{};
+  uint32_t format{};
+  uint32_t levels{};
+};
+
+struct LevelHeader {
+  uint32_t width{};
+  uint32_t height{};
+  uint32_t size{};
+};
+
+// no GPU takes bigger textures, anything beyond is a corrupt header
+constexpr uint32_t MAX_DIMENSION = 16384;
+
+size_t get_level_size(Cooker::TextureFormat a_format, uint32_t a_width, uint32_t a_height)
+{
+  size_t const blocks = static_cast<size_t>((a_width + 3) / 4) * ((a_height + 3) / 4);
+
+  switch (a_format) {
+    case Cooker::TextureFormat::RGB8:
+      return static_cast<size_t>(a_width) * a_height * 3;
+    case Cooker::TextureFormat::RGBA8:
+      return static_cast<size_t>(a_width) * a_height * 4;
+    case Cooker::TextureFormat::BC1:
+      return blocks * 8;
+    case Cooker::TextureFormat::BC3:
+      return blocks * 16;
+  }
+
+  return 0;
+}
+
+uint32_t get_max_levels(uint32_t a_width, uint32_t a_height)
+{
+  uint32_t levels{ 1 };
+  for (uint32_t size = std::max(a_width, a_height); size > 1; size /= 2)
+    ++levels;
+  return levels;
+}
+
+// 2x2 box filter, odd edges reuse the last row/column
+Cooker::TextureLevel downsample(Cooker::TextureLevel const& a_level, uint32_t a_channels)
+{
+  Cooker::TextureLevel next{};
+  next.width = std::max(1u, a_level.width / 2);
+  next.height = std::max(1u, a_level.height / 2);
+  next.data.resize(static_cast<size_t>(next.width) * next.height * a_channels);
+
+  for (uint32_t y = 0; y < next.height; ++y) {
+    uint32_t const y0 = std::min(2 * y, a_level.height - 1);
+    uint32_t const y1 = std::min(2 * y + 1, a_level.height - 1);
+
+    for (uint32_t x = 0; x < next.width; ++x) {
+      uint32_t const x0 = std::min(2 * x, a_level.width - 1);
+      uint32_t const x1 = std::min(2 * x + 1, a_level.width - 1);
+
+      for (uint32_t c = 0; c < a_channels; ++c) {
+        uint32_t const sum = a_level.data[(y0 * a_level.width + x0) * a_channels + c] +
+          a_level.data[(y0 * a_level.width + x1) * a_channels + c] +
+          a_level.data[(y1 * a_level.width + x0) * a_channels + c] +
+          a_level.data[(y1 * a_level.width + x1) * a_channels + c];
+
+        next.data[(y * next.width + x) * a_channels + c] = static_cast<uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+
+  return next;
+}
+
+uint16_t to_rgb565(uint8_t const* a_color)
+{
+  return static_cast<uint16_t>(((a_color[0] >> 3) << 11) | ((a_color[1] >> 2) << 5) | (a_color[2] >> 3));
+}
+
+void from_rgb565(uint16_t a_color, uint8_t* a_out)
+{
+  uint8_t const r = (a_color >> 11) & 31;
+  uint8_t const g = (a_color >> 5) & 63;
+  uint8_t const b = a_color & 31;
+  a_out[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+  a_out[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+  a_out[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+}
+
+// a_block holds 16 RGBA texels, writes 8 bytes
+void encode_bc1_block(uint8_t const* a_block, uint8_t* a_out)
+{
+  uint8_t minColor[3]{ 255, 255, 255 };
+  uint8_t maxColor[3]{};
+
+  for (size_t i = 0; i < 16; ++i) {
+    for (size_t c = 0; c < 3; ++c) {
+      minColor[c] = std::min(minColor[c], a_block[i * 4 + c]);
+      maxColor[c] = std::max(maxColor[c], a_block[i * 4 + c]);
+    }
+  }
+
+  // inset the bounding box slightly, endpoints on the extremes waste palette entries
+  for (size_t c = 0; c < 3; ++c) {
+    uint8_t const inset = (maxColor[c] - minColor[c]) >> 4;
+    minColor[c] += inset;
+    maxColor[c] -= inset;
+  }
+
+  uint16_t color0 = to_rgb565(maxColor);
+  uint16_t color1 = to_rgb565(minColor);
+  uint32_t indices{};
+
+  if (color0 != color1) {
+    // color0 > color1 selects the four color mode
+    if (color0 < color1)
+      std::swap(color0, color1);
+
+    uint8_t palette[4][3]{};
+    from_rgb565(color0, palette[0]);
+    from_rgb565(color1, palette[1]);
+
+    for (size_t c = 0; c < 3; ++c) {
+      palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+      palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+    }
+
+    for (size_t i = 0; i < 16; ++i) {
+      uint32_t best{};
+      int32_t bestDistance{ INT32_MAX };
+
+      for (uint32_t p = 0; p < 4; ++p) {
+        int32_t distance{};
+        for (size_t c = 0; c < 3; ++c) {
+          int32_t const d = static_cast<int32_t>(a_block[i * 4 + c]) - palette[p][c];
+          distance += d * d;
+        }
+
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          best = p;
+        }
+      }
+
+      indices |= best << (2 * i);
+    }
+  }
+
+  a_out[0] = static_cast<uint8_t>(color0 & 0xff);
+  a_out[1] = static_cast<uint8_t>(color0 >> 8);
+  a_out[2] = static_cast<uint8_t>(color1 & 0xff);
+  a_out[3] = static_cast<uint8_t>(color1 >> 8);
+  for (size_t i = 0; i < 4; ++i)
+    a_out[4 + i] = static_cast<uint8_t>((indices >> (8 * i)) & 0xff);
+}
+
+// a_block holds 16 RGBA texels, writes 8 bytes of interpolated alpha
+void encode_bc3_alpha_block(uint8_t const* a_block, uint8_t* a_out)
+{
+  uint8_t minAlpha{ 255 };
+  uint8_t maxAlpha{};
+
+  for (size_t i = 0; i < 16; ++i) {
+    minAlpha = std::min(minAlpha, a_block[i * 4 + 3]);
+    maxAlpha = std::max(maxAlpha, a_block[i * 4 + 3]);
+  }
+
+  uint64_t indices{};
+
+  if (maxAlpha != minAlpha) {
+    // alpha0 > alpha1 selects the eight value mode
+    uint8_t palette[8]{ maxAlpha, minAlpha };
+    for (uint32_t p = 1; p < 7; ++p)
+      palette[p + 1] = static_cast<uint8_t>(((7 - p) * maxAlpha + p * minAlpha) / 7);
+
+    for (size_t i = 0; i < 16; ++i) {
+      uint64_t best{};
+      int32_t bestDistance{ INT32_MAX };
+
+      for (uint32_t p = 0; p < 8; ++p) {
+        int32_t const distance = std::abs(static_cast<int32_t>(a_block[i * 4 + 3]) - palette[p]);
+        if (distance < bestDistance) {
+          bestDistance = distance;
+          best = p;
+        }
+      }
+
+      indices |= best << (3 * i);
+    }
+  }
+
+  a_out[0] = maxAlpha;
+  a_out[1] = minAlpha;
+  for (size_t i = 0; i < 6; ++i)
+    a_out[2 + i] = static_cast<uint8_t>((indices >> (8 * i)) & 0xff);
+}
+
+Cooker::TextureLevel compress(Cooker::TextureLevel const& a_level, uint32_t a_channels, Cooker::TextureFormat a_format)
+{
+  size_t const blockSize = a_format == Cooker::TextureFormat::BC1 ? 8 : 16;
+  uint32_t const blocksX = (a_level.width + 3) / 4;
+  uint32_t const blocksY = (a_level.height + 3) / 4;
+
+  Cooker::TextureLevel compressed{};
+  compressed.width = a_level.width;
+  compressed.height = a_level.height;
+  compressed.data.resize(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+  uint8_t block[16 * 4]{};
+  uint8_t* out = compressed.data.data();
+
+  for (uint32_t by = 0; by < blocksY; ++by) {
+    for (uint32_t bx = 0; bx < blocksX; ++bx) {
+      // gather the 4x4 block as RGBA, clamping at the edges of small mips
+      for (uint32_t y = 0; y < 4; ++y) {
+        for (uint32_t x = 0; x < 4; ++x) {
+          uint32_t const srcX = std::min(bx * 4 + x, a_level.width - 1);
+          uint32_t const srcY = std::min(by * 4 + y, a_level.height - 1);
+          uint8_t const* texel = &a_level.data[(srcY * a_level.width + srcX) * a_channels];
+          uint8_t* dst = &block[(y * 4 + x) * 4];
+
+          dst[0] = texel[0];
+          dst[1] = texel[1];
+          dst[2] = texel[2];
+          dst[3] = a_channels == 4 ? texel[3] : 255;
+        }
+      }
+
+      if (a_format == Cooker::TextureFormat::BC3) {
+        encode_bc3_alpha_block(block, out);
+        encode_bc1_block(block, out + 8);
+      } else {
+        encode_bc1_block(block, out);
+      }
+
+      out += blockSize;
+    }
+  }
+
+  return compressed;
+}
+
+} // namespace
+
+std::string Cooker::cooked_path(std::string_view a_sourcePath)
+{
+  return std::filesystem::path(a_sourcePath).replace_extension(".ktex").string();
+}
+
+bool Cooker::is_up_to_date(std::string_view a_sourcePath, std::string_view a_cookedPath)
+{
+  std::error_code error{};
+
+  auto const cookedTime = std::filesystem::last_write_time(a_cookedPath, error);
+  if (error)
+    return false;
+
+  // shipping only the cooked file is fine
+  auto const sourceTime = std::filesystem::last_write_time(a_sourcePath, error);
+  if (error)
+    return true;
+
+  return cookedTime >= sourceTime;
+}
+
+std::optional<Cooker::CookedTexture> Cooker::decode_texture(std::string_view a_sourcePath)
+{
+  stbi_set_flip_vertically_on_load(true);
+
+  int width{}, height{}, nrChannels{};
+  unsigned char* data = stbi_load(a_sourcePath.data(), &width, &height, &nrChannels, 0);
+  if (!data) {
+    Log::assets().error("cannot load texture {}", a_sourcePath);
+    return {};
+  }
+
+  // grey and grey-alpha images are expanded, the runtime only knows RGB and RGBA
+  if (nrChannels != 3 && nrChannels != 4) {
+    stbi_image_free(data);
+    data = stbi_load(a_sourcePath.data(), &width, &height, &nrChannels, 4);
+    nrChannels = 4;
+
+    if (!data) {
+      Log::assets().error("cannot load texture {}", a_sourcePath);
+      return {};
+    }
+  }
+
+  CookedTexture texture{};
+  texture.format = nrChannels == 4 ? TextureFormat::RGBA8 : TextureFormat::RGB8;
+  texture.levels.push_back({ static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+    std::vector<uint8_t>(data, data + static_cast<size_t>(width) * height * nrChannels) });
+  stbi_image_free(data);
+
+  return texture;
+}
+
+std::optional<Cooker::CookedTexture> Cooker::cook_texture(std::string_view a_sourcePath, bool a_compress)
+{
+  auto decoded = decode_texture(a_sourcePath);
+  if (!decoded)
+    return {};
+
+  uint32_t const channels = decoded->format == TextureFormat::RGBA8 ? 4 : 3;
+
+  std::vector<TextureLevel> levels = std::move(decoded->levels);
+  while (levels.back().width > 1 || levels.back().height > 1)
+    levels.push_back(downsample(levels.back(), channels));
+
+  CookedTexture cooked{};
+
+  if (a_compress) {
+    cooked.format = channels == 4 ? TextureFormat::BC3 : TextureFormat::BC1;
+    for (auto const& level : levels)
+      cooked.levels.push_back(compress(level, channels, cooked.format));
+  } else {
+    cooked.format = decoded->format;
+    cooked.levels = std::move(levels);
+  }
+
+  return cooked;
+}
+
+std::optional<Cooker::CookedTexture> Cooker::read_cooked_texture(std::string_view a_path)
+{
+  std::ifstream fs{ a_path.data(), std::ios::in | std::ios::binary };
+  if (!fs.is_open())
+    return {};
+
+  CookedHeader header{};
+  fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+  if (!fs || !std::equal(std::begin(COOKED_MAGIC), std::end(COOKED_MAGIC), header.magic) ||
+      header.version != COOKED_VERSION || header.format > static_cast<uint32_t>(TextureFormat::BC3)) {
+    Log::assets().error("invalid cooked texture {}", a_path);
+    return {};
+  }
+
+  CookedTexture texture{};
+  texture.format = static_cast<TextureFormat>(header.format);
+
+  // Everything read is checked against what the first level implies before it sizes a buffer,
+  // a stale or truncated file is a cache miss and the source image is decoded instead.
+  uint32_t maxLevels{ 1 };
+
+  while (texture.levels.size() < header.levels) {
+    LevelHeader levelHeader{};
+    fs.read(reinterpret_cast<char*>(&levelHeader), sizeof(levelHeader));
+    if (!fs) {
+      Log::assets().error("truncated cooked texture {}", a_path);
+      return {};
+    }
+
+    uint32_t expectedWidth{ levelHeader.width };
+    uint32_t expectedHeight{ levelHeader.height };
+
+    if (texture.levels.empty()) {
+      maxLevels = get_max_levels(levelHeader.width, levelHeader.height);
+    } else {
+      expectedWidth = std::max(1u, texture.levels.back().width / 2);
+      expectedHeight = std::max(1u, texture.levels.back().height / 2);
+    }
+
+    if (levelHeader.width == 0 || levelHeader.height == 0 || levelHeader.width > MAX_DIMENSION ||
+        levelHeader.height > MAX_DIMENSION || levelHeader.width != expectedWidth ||
+        levelHeader.height != expectedHeight || header.levels > maxLevels ||
+        levelHeader.size != get_level_size(texture.format, levelHeader.width, levelHeader.height)) {
+      Log::assets().error("invalid cooked texture {}", a_path);
+      return {};
+    }
+
+    TextureLevel level{};
+    level.width = levelHeader.width;
+    level.height = levelHeader.height;
+    level.data.resize(levelHeader.size);
+    fs.read(reinterpret_cast<char*>(level.data.data()), levelHeader.size);
+
+    if (!fs) {
+      Log::assets().error("truncated cooked texture {}", a_path);
+      return {};
+    }
+
+    texture.levels.push_back(std::move(level));
+  }
+
+  if (texture.levels.empty()) {
+    Log::assets().error("invalid cooked texture {}", a_path);
+    return {};
+  }
+
+  return texture;
+}
+
+bool Cooker::write_cooked_texture(std::string_view a_path, CookedTexture const& a_texture)
+{
+  std::ofstream fs{ a_path.data(), std::ios::out | std::ios::binary | std::ios::trunc };
+  if (!fs.is_open()) {
+    Log::assets().error("cannot write cooked texture {}", a_path);
+    return false;
+  }
+
+  CookedHeader header{};
+  std::copy(std::begin(COOKED_MAGIC), std::end(COOKED_MAGIC), header.magic);
+  header.version = COOKED_VERSION;
+  header.format = static_cast<uint32_t>(a_texture.format);
+  header.levels = static_cast<uint32_t>(a_texture.levels.size());
+  fs.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+  for (auto const& level : a_texture.levels) {
+    LevelHeader const levelHeader{ level.width, level.height, static_cast<uint32_t>(level.data.size()) };
+    fs.write(reinterpret_cast<char const*>(&levelHeader), sizeof(levelHeader));
+    fs.write(reinterpret_cast<char const*>(level.data.data()), level.data.size());
+  }
+
+  return fs.good();
+}
+
+bool Cooker::is_compressed(TextureFormat a_format)
+{
+  return a_format == TextureFormat::BC1 || a_format == TextureFormat::BC3;
+}
+
+std::string_view Cooker::get_format_name(TextureFormat a_format)
+{
+  switch (a_format)
+  {
+    case TextureFormat::RGB8: return "RGB8";
+    case TextureFormat::RGBA8: return "RGBA8";
+    case TextureFormat::BC1: return "BC1";
+    case TextureFormat::BC3: return "BC3";
+  }
+
+  return "<unknown>";
+}
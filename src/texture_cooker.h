@@ -0,0 +1,47 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Cooked textures are stored next to their source image with the ".ktex" extension.
+// The container is a tiny KTX-like format: a fixed header followed by every mip level,
+// each prefixed with its dimensions and byte size.
+namespace Cooker {
+
+  enum class TextureFormat : uint32_t {
+    RGB8,
+    RGBA8,
+    BC1,
+    BC3
+  };
+
+  struct TextureLevel {
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<uint8_t> data{};
+  };
+
+  struct CookedTexture {
+    TextureFormat format{};
+    std::vector<TextureLevel> levels{};
+  };
+
+  std::string cooked_path(std::string_view a_sourcePath);
+  bool is_up_to_date(std::string_view a_sourcePath, std::string_view a_cookedPath);
+
+  // single uncompressed level straight from the source image
+  std::optional<CookedTexture> decode_texture(std::string_view a_sourcePath);
+  std::optional<CookedTexture> cook_texture(std::string_view a_sourcePath, bool a_compress);
+  std::optional<CookedTexture> read_cooked_texture(std::string_view a_path);
+  bool write_cooked_texture(std::string_view a_path, CookedTexture const& a_texture);
+
+  bool is_compressed(TextureFormat a_format);
+  std::string_view get_format_name(TextureFormat a_format);
+
+} // namespace Cooker
+
+#endif //TEXTURE_COOKER_H
@@ -0,0 +1,56 @@
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "log.h"
+#include "texture_cooker.h"
+
+// Usage: TextureCooker [--uncompressed] [image.png ...]
+// Without explicit images every PNG in data/textures is cooked.
+int main(int argc, char **argv)
+{
+  Log::init();
+
+  bool compress{ true };
+  std::vector<std::string> sources{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg{ argv[i] };
+    if (arg == "--uncompressed")
+      compress = false;
+    else
+      sources.push_back(arg);
+  }
+
+  if (sources.empty()) {
+    std::error_code error{};
+    for (auto const& entry : std::filesystem::directory_iterator("data/textures", error)) {
+      if (entry.path().extension() == ".png")
+        sources.push_back(entry.path().string());
+    }
+  }
+
+  int result{ EXIT_SUCCESS };
+
+  for (auto const& source : sources) {
+    auto cooked = Cooker::cook_texture(source, compress);
+    auto const cookedPath = Cooker::cooked_path(source);
+
+    if (!cooked || !Cooker::write_cooked_texture(cookedPath, *cooked)) {
+      result = EXIT_FAILURE;
+      continue;
+    }
+
+    size_t bytes{};
+    for (auto const& level : cooked->levels)
+      bytes += level.data.size();
+
+    std::cout << source << " -> " << cookedPath << " (" << Cooker::get_format_name(cooked->format) << ", "
+      << cooked->levels.size() << " levels, " << bytes / 1024 << " KiB)" << std::endl;
+  }
+
+  Log::shutdown();
+  return result;
+}
@@ -1,7 +1,11 @@
 #include "utils.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <fstream>
-#include <iostream>
+#include <iterator>
 #include <string>
 #include <string_view>
 
@@ -12,13 +16,117 @@
 
 #include <tiny_obj_loader.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "log.h"
+#include "memory_tracker.h"
+#include "texture_cooker.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
 
 const int VERTEX_LOCATION = 0;
 const int TEXTURE_LOCATION = 1;
 const int COLOR_LOCATION = 2;
 
+const float MAX_ANISOTROPY = 8.0f;
+
+const char* const SHADER_CACHE_DIR = "data/cache";
+
+namespace {
+
+// The debug callback asserts on every message. Where an error is an expected outcome that is
+// checked and handled right after, its messages are muted for the duration of the probe.
+class ScopedDebugMute {
+public:
+  ScopedDebugMute(GLenum a_source, GLenum a_type)
+    : m_source{ a_source }
+    , m_type{ a_type }
+  {
+    glDebugMessageControl(m_source, m_type, GL_DONT_CARE, 0, nullptr, GL_FALSE);
+  }
+
+  ~ScopedDebugMute()
+  {
+    glDebugMessageControl(m_source, m_type, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+  }
+
+  ScopedDebugMute(ScopedDebugMute const&) = delete;
+  ScopedDebugMute& operator=(ScopedDebugMute const&) = delete;
+
+private:
+  GLenum m_source{};
+  GLenum m_type{};
+};
+
+// trilinear filtering plus anisotropy, clamped to what the driver supports
+void set_texture_filtering()
+{
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  float maxAnisotropy{};
+  glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+  if (maxAnisotropy > 1.0f)
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY, std::min(maxAnisotropy, MAX_ANISOTROPY));
+}
+
+bool compile_shader(std::string_view a_source, std::string_view a_name, ShaderType a_type, Shader& a_shader)
+{
+  uint32_t newShader{};
+  switch (a_type) {
+    case ShaderType::Vertex:
+      newShader = glCreateShader(GL_VERTEX_SHADER);
+      break;
+    case ShaderType::Fragment:
+      newShader = glCreateShader(GL_FRAGMENT_SHADER);
+      break;
+  }
+
+  int status{};
+  char log[512]{};
+
+  const char* const shaderData = a_source.data();
+  const int shaderLength = static_cast<int>(a_source.size());
+  glShaderSource(newShader, 1, &shaderData, &shaderLength);
+  glCompileShader(newShader);
+
+  glGetShaderiv(newShader, GL_COMPILE_STATUS, &status);
+  glGetShaderInfoLog(newShader, 512, nullptr, log);
+
+  if (!status) {
+    Log::render().error("Error compiling shader {}:\n{}", a_name, log);
+  } else {
+    glAttachShader(a_shader.program, newShader);
+  }
+
+  // attached shaders stay alive until the program is deleted
+  glDeleteShader(newShader);
+  return status;
+}
+
+} // namespace
+
+
+uint64_t Utils::fnv1a(void const* a_data, size_t a_size, uint64_t a_hash)
+{
+  auto const* bytes = static_cast<uint8_t const*>(a_data);
+  for (size_t i = 0; i < a_size; ++i) {
+    a_hash ^= bytes[i];
+    a_hash *= 1099511628211ull;
+  }
+  return a_hash;
+}
 
 std::optional<std::string> Utils::open_file(std::string_view a_path)
 {
@@ -33,76 +141,263 @@ std::optional<std::string> Utils::open_file(std::string_view a_path)
     }
     fs.close();
   } else {
-    std::cerr << "cannot open file" << std::endl;
+    Log::assets().error("cannot open file {}", a_path);
     return {};
   }
   return output;
 }
 
-Texture Utils::load_texture(std::string_view a_path)
+std::optional<Cooker::CookedTexture> Utils::read_texture(std::string_view a_path)
 {
-  stbi_set_flip_vertically_on_load(true);
+  auto const cookedPath = Cooker::cooked_path(a_path);
+  if (Cooker::is_up_to_date(a_path, cookedPath)) {
+    if (auto cooked = Cooker::read_cooked_texture(cookedPath))
+      return cooked;
+  }
+
+  return Cooker::decode_texture(a_path);
+}
 
-  int width{}, height{}, nrChannels{};
-  unsigned char* data = stbi_load(a_path.data(), &width, &height, &nrChannels, 0);
-  if (!data) {
-    std::cerr << "cannot load texture" << std::endl;
+Texture Utils::create_texture(Cooker::CookedTexture const& a_data, size_t& a_bytes)
+{
+  if (a_data.levels.empty())
     return {};
-  }
 
   Texture texture{};
   glGenTextures(1, &texture.texture);
   glBindTexture(GL_TEXTURE_2D, texture.texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // drain stale errors so a rejected upload can be detected below
+  while (glGetError() != GL_NO_ERROR) {}
+
+  a_bytes = 0;
+
+  GLint level{};
+
+  {
+    ScopedDebugMute const mute{ GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR };
+
+    for (auto const& data : a_data.levels) {
+      auto const width = static_cast<GLsizei>(data.width);
+      auto const height = static_cast<GLsizei>(data.height);
+      auto const size = static_cast<GLsizei>(data.data.size());
+
+      switch (a_data.format) {
+        case Cooker::TextureFormat::RGB8:
+          glTexImage2D(GL_TEXTURE_2D, level, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data.data.data());
+          break;
+        case Cooker::TextureFormat::RGBA8:
+          glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data.data());
+          break;
+        case Cooker::TextureFormat::BC1:
+          glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height, 0, size, data.data.data());
+          break;
+        case Cooker::TextureFormat::BC3:
+          glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, width, height, 0, size, data.data.data());
+          break;
+      }
 
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      a_bytes += data.data.size();
+      ++level;
+    }
+  }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-  const auto format = nrChannels == 4 ? GL_RGBA : GL_RGB;
+  if (glGetError() != GL_NO_ERROR) {
+    Log::render().warn("texture rejected by the driver");
+    glDeleteTextures(1, &texture.texture);
+    a_bytes = 0;
+    return {};
+  }
+
+  // a single uncompressed level comes from a png, build the rest of the chain here
+  if (level == 1 && !Cooker::is_compressed(a_data.format) && (a_data.levels[0].width > 1 || a_data.levels[0].height > 1)) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+    a_bytes = a_bytes * 4 / 3;
+  } else {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+  }
+
+  set_texture_filtering();
 
-  glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-  glGenerateMipmap(GL_TEXTURE_2D);
+  Memory::track_gl_texture(texture.texture, a_bytes);
 
-  stbi_image_free(data);
   return texture;
 }
 
-void Utils::load_shader(std::string_view a_path, ShaderType a_type, Shader& a_shader)
+Texture Utils::load_texture(std::string_view a_path)
 {
-  uint32_t newShader{};
-  switch (a_type) {
-    case ShaderType::Vertex:
-      newShader = glCreateShader(GL_VERTEX_SHADER);
-      break;
-    case ShaderType::Fragment:
-      newShader = glCreateShader(GL_FRAGMENT_SHADER);
-      break;
+  using clock_t = std::chrono::high_resolution_clock;
+  using duration = std::chrono::duration<double, std::milli>;
+  auto const start = clock_t::now();
+
+  Texture texture{};
+  size_t bytes{};
+  std::string_view format{};
+
+  if (auto data = read_texture(a_path)) {
+    texture = create_texture(*data, bytes);
+    format = Cooker::get_format_name(data->format);
+  }
+
+  // a cooked file the driver refuses still leaves the png
+  if (!texture.texture && Cooker::is_up_to_date(a_path, Cooker::cooked_path(a_path))) {
+    if (auto data = Cooker::decode_texture(a_path)) {
+      texture = create_texture(*data, bytes);
+      format = Cooker::get_format_name(data->format);
+    }
   }
 
-  if (auto shaderSource = open_file(a_path)) {
-    int status{};
-    char log[512]{};
+  if (!texture.texture) {
+    Log::assets().error("cannot load texture {}", a_path);
+    return {};
+  }
 
-    const char* const shaderData = (*shaderSource).data();
-    glShaderSource(newShader, 1, &shaderData, nullptr);
-    glCompileShader(newShader);
+  const duration loadTime = clock_t::now() - start;
+  Log::assets().info("Texture {}: {}, {:.2f} ms, {} KiB VRAM", a_path, format, loadTime.count(), bytes / 1024);
 
-    glGetShaderiv(newShader, GL_COMPILE_STATUS, &status);
-    glGetShaderInfoLog(newShader, 512, nullptr, log);
+  return texture;
+}
 
-    if (!status) {
-      std::cerr << "Error compiling shader " << a_path << ":\n";
-      std::cerr << log << std::endl;
+void Utils::delete_texture(Texture& a_texture)
+{
+  Memory::untrack_gl_texture(a_texture.texture);
+  glDeleteTextures(1, &a_texture.texture);
+  a_texture = {};
+}
+
+bool Utils::load_shader(std::string_view a_path, ShaderType a_type, Shader& a_shader)
+{
+  if (auto shaderSource = open_file(a_path))
+    return compile_shader(*shaderSource, a_path, a_type, a_shader);
+
+  return false;
+}
+
+bool Utils::link_program(Shader& a_shader)
+{
+  int status{};
+  char log[512]{};
+
+  glLinkProgram(a_shader.program);
+
+  glGetProgramiv(a_shader.program, GL_LINK_STATUS, &status);
+  if (!status) {
+    glGetProgramInfoLog(a_shader.program, 512, nullptr, log);
+    Log::render().error("Error linking program:\n{}", log);
+  }
+
+  return status;
+}
+
+bool Utils::load_program(std::string_view a_vertexPath, std::string_view a_fragmentPath, Shader& a_shader)
+{
+  auto vertexSource = open_file(a_vertexPath);
+  auto fragmentSource = open_file(a_fragmentPath);
+
+  if (!vertexSource || !fragmentSource)
+    return false;
+
+  // one file per program, hot reload overwrites it instead of leaving stale binaries behind
+  std::string program{ a_vertexPath };
+  program += '\0';
+  program += a_fragmentPath;
+
+  char programHash[17]{};
+  std::snprintf(programHash, sizeof(programHash), "%016llx",
+    static_cast<unsigned long long>(fnv1a(program.data(), program.size())));
+  std::string const cachePath = std::string{ SHADER_CACHE_DIR } + "/shader_" + programHash + ".bin";
+
+  // binaries are only valid for the exact sources and driver that produced them
+  std::string key{ *vertexSource };
+  key += '\0';
+  key += *fragmentSource;
+  for (GLenum const name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+    key += '\0';
+    key += reinterpret_cast<const char*>(glGetString(name));
+  }
+
+  uint64_t const hash{ fnv1a(key.data(), key.size()) };
+
+  int binaryFormats{};
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+
+  Shader shader{};
+  shader.program = glCreateProgram();
+
+  if (binaryFormats > 0) {
+    std::ifstream fs{ cachePath, std::ios::in | std::ios::binary };
+
+    uint64_t storedHash{};
+    fs.read(reinterpret_cast<char*>(&storedHash), sizeof(storedHash));
+
+    // a binary of older sources is skipped without asking the driver
+    if (fs && storedHash == hash) {
+      // a binary from another driver build is expected to be refused
+      ScopedDebugMute const muteApi{ GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR };
+      ScopedDebugMute const muteCompiler{ GL_DEBUG_SOURCE_SHADER_COMPILER, GL_DONT_CARE };
+
+      uint32_t format{};
+      fs.read(reinterpret_cast<char*>(&format), sizeof(format));
+      std::vector<char> binary{ std::istreambuf_iterator<char>(fs), std::istreambuf_iterator<char>() };
+
+      int status{};
+      glProgramBinary(shader.program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+      glGetProgramiv(shader.program, GL_LINK_STATUS, &status);
+
+      if (status) {
+        a_shader = shader;
+        return true;
+      }
+
+      // driver update or corrupted cache, start over from source
+      Log::render().info("shader binary rejected, recompiling");
+      glDeleteProgram(shader.program);
+      shader.program = glCreateProgram();
     }
+  }
 
-    assert(status);
+  glProgramParameteri(shader.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
-    glAttachShader(a_shader.program, newShader);
+  {
+    // a broken shader saved during hot reload is logged by compile_shader and the old program kept
+    ScopedDebugMute const mute{ GL_DEBUG_SOURCE_SHADER_COMPILER, GL_DONT_CARE };
+
+    if (!compile_shader(*vertexSource, a_vertexPath, ShaderType::Vertex, shader) ||
+        !compile_shader(*fragmentSource, a_fragmentPath, ShaderType::Fragment, shader) ||
+        !link_program(shader)) {
+      glDeleteProgram(shader.program);
+      return false;
+    }
   }
 
-  glLinkProgram(a_shader.program);
-  glDeleteShader(newShader);
+  if (binaryFormats > 0) {
+    int length{};
+    glGetProgramiv(shader.program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    std::vector<char> binary(length);
+    GLenum format{};
+    glGetProgramBinary(shader.program, length, nullptr, &format, binary.data());
+
+    std::error_code error{};
+    std::filesystem::create_directories(SHADER_CACHE_DIR, error);
+
+    std::ofstream fs{ cachePath, std::ios::out | std::ios::binary | std::ios::trunc };
+    if (fs.is_open()) {
+      uint32_t const storedFormat{ format };
+      fs.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+      fs.write(reinterpret_cast<const char*>(&storedFormat), sizeof(storedFormat));
+      fs.write(binary.data(), binary.size());
+    } else {
+      Log::render().warn("cannot write shader cache {}", cachePath);
+    }
+  }
+
+  a_shader = shader;
+  return true;
 }
 
 Model Utils::load_model(const std::vector<float>& a_data)
@@ -117,6 +412,7 @@ Model Utils::load_model(const std::vector<float>& a_data)
 
   glBindBuffer(GL_ARRAY_BUFFER, vbo);
   glBufferData(GL_ARRAY_BUFFER, sizeof(float) * a_data.size(), a_data.data(), GL_STATIC_DRAW);
+  Memory::track_gl_buffer(vbo, sizeof(float) * a_data.size());
 
   glVertexAttribPointer(VERTEX_LOCATION, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
   glEnableVertexAttribArray(VERTEX_LOCATION);
@@ -132,7 +428,7 @@ Model Utils::load_model(const std::vector<float>& a_data)
   return model;
 }
 
-Model Utils::load_model(std::string_view a_path)
+std::optional<std::vector<float>> Utils::read_model(std::string_view a_path)
 {
   tinyobj::attrib_t attribs{};
   std::vector<tinyobj::shape_t> shapes{};
@@ -143,10 +439,10 @@ Model Utils::load_model(std::string_view a_path)
   bool const loaded = tinyobj::LoadObj(&attribs, &shapes, nullptr, &warnings, &errors, a_path.data());
 
   if (!errors.empty())
-    std::cout << "Errors: " << errors << std::endl;
+    Log::assets().error("{}: {}", a_path, errors);
 
   if (!warnings.empty())
-    std::cout << "Warning: " << warnings << std::endl;
+    Log::assets().warn("{}: {}", a_path, warnings);
 
   if (!loaded)
     return {};
@@ -188,5 +484,27 @@ Model Utils::load_model(std::string_view a_path)
     }
   }
 
-  return load_model(modelVertices);
+  return modelVertices;
+}
+
+Model Utils::load_model(std::string_view a_path)
+{
+  if (auto vertices = read_model(a_path))
+    return load_model(*vertices);
+
+  return {};
+}
+
+void Utils::delete_model(Model& a_model)
+{
+  int vbo{};
+  glBindVertexArray(a_model.vao);
+  glGetVertexAttribiv(VERTEX_LOCATION, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &vbo);
+  glBindVertexArray(0);
+
+  uint32_t buffer{ static_cast<uint32_t>(vbo) };
+  Memory::untrack_gl_buffer(buffer);
+  glDeleteBuffers(1, &buffer);
+  glDeleteVertexArrays(1, &a_model.vao);
+  a_model = {};
 }
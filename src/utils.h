@@ -2,6 +2,7 @@
 #define ULILS_H
 
 #include "data_types.h"
+#include "texture_cooker.h"
 
 #include <optional>
 #include <string>
@@ -9,12 +10,25 @@
 
 namespace Utils {
 
+  constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+  uint64_t fnv1a(void const* a_data, size_t a_size, uint64_t a_hash = FNV_OFFSET_BASIS);
+
   std::optional<std::string> open_file(std::string_view a_path);
 
+  // read_* functions only touch the CPU and are safe to call off the main thread
+  std::optional<Cooker::CookedTexture> read_texture(std::string_view a_path);
+  Texture create_texture(Cooker::CookedTexture const& a_data, size_t& a_bytes);
   Texture load_texture(std::string_view a_path);
-  void load_shader(std::string_view a_path, ShaderType a_type, Shader& a_shader);
+  void delete_texture(Texture& a_texture);
+  bool load_shader(std::string_view a_path, ShaderType a_type, Shader& a_shader);
+  bool link_program(Shader& a_shader);
+  // compiles and links both stages, reusing a cached program binary when the driver accepts it
+  bool load_program(std::string_view a_vertexPath, std::string_view a_fragmentPath, Shader& a_shader);
   Model load_model(const std::vector<float>& a_data);
+  std::optional<std::vector<float>> read_model(std::string_view a_path);
   Model load_model(std::string_view a_path);
+  void delete_model(Model& a_model);
 
 }; // namespace utils
 